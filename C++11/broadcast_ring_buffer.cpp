@@ -0,0 +1,177 @@
+/*
+    Copyright 2011 Emilio Guijarro
+
+    This file is part of the Ring Buffer library.
+
+    The Ring Buffer library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Ring Buffer library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Ring Buffer library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "broadcast_ring_buffer.hpp"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+
+struct broadcast_ring_buffer::broadcast_ring_buffer_implementation {
+    struct _reader {
+        size_t position;
+        bool active;
+    };
+
+
+    std::unique_ptr<char[]> buffer;
+    size_t capacity, mask, _write;
+    bool lapping;
+    std::vector<_reader> readers;
+    std::mutex mutex;
+
+
+    inline size_t ring_buffer_offset(size_t position) { return (0 != mask) ? (position & mask) : (position % capacity); }
+
+
+    broadcast_ring_buffer_implementation(size_t capacity, bool lapping) throw (ring_buffer_out_of_memory_exception) : capacity(capacity), mask((0 == (capacity & (capacity - 1))) ? capacity - 1 : 0), _write(0), lapping(lapping) {
+        try {
+            buffer.reset(new char[capacity]);
+        } catch (std::bad_alloc&) {
+            throw ring_buffer_out_of_memory_exception{};
+        }
+    }
+
+
+    _reader& reader_at(ring_buffer_reader reader) throw (ring_buffer_invalid_reader_exception) {
+        if ((reader >= readers.size()) or not readers[reader].active)
+            throw ring_buffer_invalid_reader_exception{};
+
+        return readers[reader];
+    }
+
+
+    // A bounded ring can only reuse what every reader is done with; with no readers
+    // at all (or when lapping) the whole capacity is writable
+    size_t ring_buffer_writable() {
+        auto result = capacity;
+
+        if (not lapping)
+            for (auto& reader : readers)
+                if (reader.active)
+                    result = std::min(result, capacity - (_write - reader.position));
+
+        return result;
+    }
+
+
+    ring_buffer_reader add_reader() throw (ring_buffer_out_of_memory_exception) {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto result = std::find_if(readers.begin(), readers.end(), [](const _reader& reader) { return not reader.active; }) - readers.begin();
+
+        try {
+            if (readers.size() == static_cast<size_t>(result))
+                readers.push_back(_reader{_write, true});
+            else
+                readers[result] = _reader{_write, true};
+        } catch (std::bad_alloc&) {
+            throw ring_buffer_out_of_memory_exception{};
+        }
+
+        return result;
+    }
+
+
+    void remove_reader(ring_buffer_reader reader) throw (ring_buffer_invalid_reader_exception) {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        reader_at(reader).active = false;
+    }
+
+
+    bool try_write(const void* data, size_t length) throw (ring_buffer_invalid_address_exception) {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto result = false;
+
+        if (nullptr != data) {
+            if (ring_buffer_writable() >= length) {
+                auto target = ring_buffer_offset(_write), size = std::min(length, capacity - target);
+
+                memcpy(buffer.get() + target, data, size);
+                memcpy(buffer.get(), reinterpret_cast<const char*>(data) + size, length - size);
+                _write += length;
+                result = true;
+            }
+        }
+        else
+            throw ring_buffer_invalid_address_exception{};
+
+        return result;
+    }
+
+
+    void write(const void* data, size_t length) throw (ring_buffer_overflow_exception, ring_buffer_invalid_address_exception) {
+        if (not try_write(data, length))
+            throw ring_buffer_overflow_exception{};
+    }
+
+
+    bool try_read(ring_buffer_reader reader, void* data, size_t length) throw (ring_buffer_invalid_address_exception, ring_buffer_invalid_reader_exception, ring_buffer_lapped_exception) {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto& cursor = reader_at(reader);
+        auto result = false;
+
+        if (nullptr != data) {
+            if (_write - cursor.position > capacity) {
+                cursor.position = _write - capacity;
+                throw ring_buffer_lapped_exception{};
+            }
+
+            if (_write - cursor.position >= length) {
+                auto target = ring_buffer_offset(cursor.position), size = std::min(length, capacity - target);
+
+                memcpy(data, buffer.get() + target, size);
+                memcpy(reinterpret_cast<char*>(data) + size, buffer.get(), length - size);
+                cursor.position += length;
+                result = true;
+            }
+        }
+        else
+            throw ring_buffer_invalid_address_exception{};
+
+        return result;
+    }
+
+
+    void read(ring_buffer_reader reader, void* data, size_t length) throw (ring_buffer_underflow_exception, ring_buffer_invalid_address_exception, ring_buffer_invalid_reader_exception, ring_buffer_lapped_exception) {
+        if (not try_read(reader, data, length))
+            throw ring_buffer_underflow_exception{};
+    }
+
+
+    void get_available(ring_buffer_reader reader, size_t& read, size_t& write) throw (ring_buffer_invalid_reader_exception) {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        read = std::min(capacity, _write - reader_at(reader).position);
+        write = ring_buffer_writable();
+    }
+};
+
+
+broadcast_ring_buffer::broadcast_ring_buffer(size_t capacity, bool lapping) throw (ring_buffer_out_of_memory_exception) : implementation(new broadcast_ring_buffer_implementation{capacity, lapping}) { }
+broadcast_ring_buffer::ring_buffer_reader broadcast_ring_buffer::add_reader() throw (ring_buffer_out_of_memory_exception) { return implementation->add_reader(); }
+void broadcast_ring_buffer::remove_reader(ring_buffer_reader reader) throw (ring_buffer_invalid_reader_exception) { implementation->remove_reader(reader); }
+void broadcast_ring_buffer::write(const void* data, size_t length) throw (ring_buffer_overflow_exception, ring_buffer_invalid_address_exception) { implementation->write(data, length); }
+void broadcast_ring_buffer::read(ring_buffer_reader reader, void* data, size_t length) throw (ring_buffer_underflow_exception, ring_buffer_invalid_address_exception, ring_buffer_invalid_reader_exception, ring_buffer_lapped_exception) { implementation->read(reader, data, length); }
+bool broadcast_ring_buffer::try_write(const void* data, size_t length) throw (ring_buffer_invalid_address_exception) { return implementation->try_write(data, length); }
+bool broadcast_ring_buffer::try_read(ring_buffer_reader reader, void* data, size_t length) throw (ring_buffer_invalid_address_exception, ring_buffer_invalid_reader_exception, ring_buffer_lapped_exception) { return implementation->try_read(reader, data, length); }
+void broadcast_ring_buffer::get_available(ring_buffer_reader reader, size_t& read, size_t& write) throw (ring_buffer_invalid_reader_exception) { implementation->get_available(reader, read, write); }
+broadcast_ring_buffer::~broadcast_ring_buffer() throw () { }
@@ -0,0 +1,53 @@
+/*
+    Copyright 2011 Emilio Guijarro
+
+    This file is part of the Ring Buffer library.
+
+    The Ring Buffer library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Ring Buffer library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Ring Buffer library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+
+#include "ring_buffer.hpp"
+
+
+// Byte ring written by one producer and read by any number of registered readers,
+// each with its own cursor, so the data is stored once however many readers consume
+// it. A bounded ring never lets the producer overwrite what its slowest reader has
+// not read yet; a lapping ring always accepts writes and a reader that fell more than
+// a capacity behind gets ring_buffer_lapped_exception once and resumes at the oldest
+// byte still stored. A new reader starts at the current write position.
+class broadcast_ring_buffer {
+private:
+    class broadcast_ring_buffer_implementation; std::unique_ptr<broadcast_ring_buffer_implementation> implementation;
+
+
+public:
+    typedef size_t ring_buffer_reader;
+
+
+    broadcast_ring_buffer(size_t capacity, bool lapping) throw (ring_buffer_out_of_memory_exception);
+    broadcast_ring_buffer(const broadcast_ring_buffer& other) = delete;
+    broadcast_ring_buffer& operator=(const broadcast_ring_buffer& other) = delete;
+    ring_buffer_reader add_reader() throw (ring_buffer_out_of_memory_exception);
+    void remove_reader(ring_buffer_reader reader) throw (ring_buffer_invalid_reader_exception);
+    void write(const void* data, size_t length) throw (ring_buffer_overflow_exception, ring_buffer_invalid_address_exception);
+    void read(ring_buffer_reader reader, void* data, size_t length) throw (ring_buffer_underflow_exception, ring_buffer_invalid_address_exception, ring_buffer_invalid_reader_exception, ring_buffer_lapped_exception);
+    bool try_write(const void* data, size_t length) throw (ring_buffer_invalid_address_exception);
+    bool try_read(ring_buffer_reader reader, void* data, size_t length) throw (ring_buffer_invalid_address_exception, ring_buffer_invalid_reader_exception, ring_buffer_lapped_exception);
+    void get_available(ring_buffer_reader reader, size_t& read, size_t& write) throw (ring_buffer_invalid_reader_exception);
+    ~broadcast_ring_buffer() throw ();
+};
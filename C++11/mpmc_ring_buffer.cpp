@@ -0,0 +1,165 @@
+/*
+    Copyright 2011 Emilio Guijarro
+
+    This file is part of the Ring Buffer library.
+
+    The Ring Buffer library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Ring Buffer library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Ring Buffer library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "mpmc_ring_buffer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+
+struct mpmc_ring_buffer::mpmc_ring_buffer_implementation {
+    typedef std::atomic<size_t> sequence;
+
+
+    static const size_t cache_line_size = 64;
+
+
+    // Writers and readers each own one cursor; the padding keeps them on separate cache lines
+    std::unique_ptr<char[]> buffer;
+    size_t record_size, stride, capacity, mask;
+    char _padding0[cache_line_size];
+    sequence _write;
+    char _padding1[cache_line_size - sizeof(sequence)];
+    sequence _read;
+    char _padding2[cache_line_size - sizeof(sequence)];
+
+
+    inline sequence& sequence_at(size_t position) { return *reinterpret_cast<sequence*>(buffer.get() + (position & mask) * stride); }
+    inline char* record_at(size_t position) { return buffer.get() + (position & mask) * stride + sizeof(sequence); }
+
+
+    static size_t round_up_power_of_two(size_t value) throw (ring_buffer_out_of_memory_exception) {
+        size_t result = 1;
+
+        while (result < value) {
+            // Doubling past the top bit wraps to zero; nothing that large can be allocated anyway
+            if (0 == (result << 1))
+                throw ring_buffer_out_of_memory_exception{};
+
+            result <<= 1;
+        }
+
+        return result;
+    }
+
+
+    mpmc_ring_buffer_implementation(size_t record_size, size_t capacity) throw (ring_buffer_out_of_memory_exception) : record_size(record_size), stride((sizeof(sequence) + record_size + alignof(sequence) - 1) / alignof(sequence) * alignof(sequence)), capacity(round_up_power_of_two(capacity)), mask(this->capacity - 1), _write(0), _read(0) {
+        // A stride that wrapped comes out smaller than the record, and the buffer size
+        // must not wrap either, or the sequences below would be written past its end
+        if ((stride < record_size) or (this->capacity > SIZE_MAX / stride))
+            throw ring_buffer_out_of_memory_exception{};
+
+        try {
+            buffer.reset(new char[this->capacity * stride]);
+        } catch (std::bad_alloc&) {
+            throw ring_buffer_out_of_memory_exception{};
+        }
+
+        // A slot is writable for position p when its sequence equals p, readable when it equals p + 1
+        for (size_t i = 0; i < this->capacity; i++)
+            new (&sequence_at(i)) sequence(i);
+    }
+
+
+    bool try_write(const void* record) throw (ring_buffer_invalid_address_exception) {
+        auto result = false;
+
+        if (nullptr != record) {
+            auto position = _write.load(std::memory_order_relaxed);
+
+            for (;;) {
+                auto difference = static_cast<intptr_t>(sequence_at(position).load(std::memory_order_acquire)) - static_cast<intptr_t>(position);
+
+                if (0 == difference) {
+                    if (_write.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        memcpy(record_at(position), record, record_size);
+                        sequence_at(position).store(position + 1, std::memory_order_release);
+                        result = true;
+                        break;
+                    }
+                }
+                else if (difference < 0)
+                    break; // The slot still holds a record from the previous lap: full
+                else
+                    position = _write.load(std::memory_order_relaxed);
+            }
+        }
+        else
+            throw ring_buffer_invalid_address_exception{};
+
+        return result;
+    }
+
+
+    bool try_read(void* record) throw (ring_buffer_invalid_address_exception) {
+        auto result = false;
+
+        if (nullptr != record) {
+            auto position = _read.load(std::memory_order_relaxed);
+
+            for (;;) {
+                auto difference = static_cast<intptr_t>(sequence_at(position).load(std::memory_order_acquire)) - static_cast<intptr_t>(position + 1);
+
+                if (0 == difference) {
+                    if (_read.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                        memcpy(record, record_at(position), record_size);
+                        sequence_at(position).store(position + capacity, std::memory_order_release);
+                        result = true;
+                        break;
+                    }
+                }
+                else if (difference < 0)
+                    break; // The slot has not been written in this lap yet: empty
+                else
+                    position = _read.load(std::memory_order_relaxed);
+            }
+        }
+        else
+            throw ring_buffer_invalid_address_exception{};
+
+        return result;
+    }
+
+
+    void get_available(size_t& read, size_t& write) throw () {
+        // Only a snapshot: other threads may move either cursor right after it is taken
+        auto consumed = _read.load(std::memory_order_acquire);
+
+        read = std::min(capacity, _write.load(std::memory_order_acquire) - consumed);
+        write = capacity - read;
+    }
+
+
+    ~mpmc_ring_buffer_implementation() {
+        for (size_t i = 0; i < capacity; i++)
+            sequence_at(i).~sequence();
+    }
+};
+
+
+mpmc_ring_buffer::mpmc_ring_buffer(size_t record_size, size_t capacity) throw (ring_buffer_out_of_memory_exception) : implementation(new mpmc_ring_buffer_implementation{record_size, capacity}) { }
+void mpmc_ring_buffer::write(const void* record) throw (ring_buffer_overflow_exception, ring_buffer_invalid_address_exception) { if (not implementation->try_write(record)) throw ring_buffer_overflow_exception{}; }
+void mpmc_ring_buffer::read(void* record) throw (ring_buffer_underflow_exception, ring_buffer_invalid_address_exception) { if (not implementation->try_read(record)) throw ring_buffer_underflow_exception{}; }
+bool mpmc_ring_buffer::try_write(const void* record) throw (ring_buffer_invalid_address_exception) { return implementation->try_write(record); }
+bool mpmc_ring_buffer::try_read(void* record) throw (ring_buffer_invalid_address_exception) { return implementation->try_read(record); }
+void mpmc_ring_buffer::get_available(size_t& read, size_t& write) throw () { implementation->get_available(read, write); }
+mpmc_ring_buffer::~mpmc_ring_buffer() throw () { }
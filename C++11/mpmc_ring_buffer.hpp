@@ -0,0 +1,46 @@
+/*
+    Copyright 2011 Emilio Guijarro
+
+    This file is part of the Ring Buffer library.
+
+    The Ring Buffer library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Ring Buffer library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Ring Buffer library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+
+#include "ring_buffer.hpp"
+
+
+// Lock-free ring of fixed-size records for any number of writer and reader threads.
+// Every slot carries a sequence number (D. Vyukov's bounded MPMC queue), so threads
+// only contend on the cursor they advance and never wait for each other. Capacity is
+// counted in records and rounded up to a power of two.
+class mpmc_ring_buffer {
+private:
+    class mpmc_ring_buffer_implementation; std::unique_ptr<mpmc_ring_buffer_implementation> implementation;
+
+
+public:
+    mpmc_ring_buffer(size_t record_size, size_t capacity) throw (ring_buffer_out_of_memory_exception);
+    mpmc_ring_buffer(const mpmc_ring_buffer& other) = delete;
+    mpmc_ring_buffer& operator=(const mpmc_ring_buffer& other) = delete;
+    void write(const void* record) throw (ring_buffer_overflow_exception, ring_buffer_invalid_address_exception);
+    void read(void* record) throw (ring_buffer_underflow_exception, ring_buffer_invalid_address_exception);
+    bool try_write(const void* record) throw (ring_buffer_invalid_address_exception);
+    bool try_read(void* record) throw (ring_buffer_invalid_address_exception);
+    void get_available(size_t& read, size_t& write) throw ();
+    ~mpmc_ring_buffer() throw ();
+};
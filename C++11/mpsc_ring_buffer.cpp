@@ -0,0 +1,178 @@
+/*
+    Copyright 2011 Emilio Guijarro
+
+    This file is part of the Ring Buffer library.
+
+    The Ring Buffer library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Ring Buffer library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Ring Buffer library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "mpsc_ring_buffer.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+
+struct mpsc_ring_buffer::mpsc_ring_buffer_implementation {
+    typedef std::atomic<size_t> header;
+
+
+    static_assert(sizeof(header) == sizeof(size_t), "record headers must overlay a size_t");
+    static const size_t cache_line_size = 64;
+    static const size_t alignment = sizeof(header);
+    static const size_t committed = 1, padding = 2, flag_bits = 2;
+
+
+    // The write cursor is shared by all writers and the read cursor belongs to the reader
+    std::unique_ptr<size_t[]> words;
+    size_t capacity, mask;
+    char _padding0[cache_line_size];
+    std::atomic<size_t> _write;
+    char _padding1[cache_line_size - sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> _read;
+    char _padding2[cache_line_size - sizeof(std::atomic<size_t>)];
+
+
+    inline char* buffer() { return reinterpret_cast<char*>(words.get()); }
+    inline header& header_at(size_t position) { return *reinterpret_cast<header*>(buffer() + (position & mask)); }
+    inline static size_t record_size(size_t length) { return (sizeof(header) + length + alignment - 1) / alignment * alignment; }
+
+
+    static size_t round_up_power_of_two(size_t value) throw (ring_buffer_out_of_memory_exception) {
+        size_t result = 1;
+
+        while (result < value) {
+            // Doubling past the top bit wraps to zero; nothing that large can be allocated anyway
+            if (0 == (result << 1))
+                throw ring_buffer_out_of_memory_exception{};
+
+            result <<= 1;
+        }
+
+        return result;
+    }
+
+
+    mpsc_ring_buffer_implementation(size_t capacity) throw (ring_buffer_out_of_memory_exception) : capacity(round_up_power_of_two((capacity < 2 * alignment) ? 2 * alignment : capacity)), mask(this->capacity - 1), _write(0), _read(0) {
+
+        // A zero header means "not committed yet", so the storage starts (and is kept) zeroed
+        try {
+            words.reset(new size_t[this->capacity / alignment]());
+        } catch (std::bad_alloc&) {
+            throw ring_buffer_out_of_memory_exception{};
+        }
+    }
+
+
+    // Records never wrap: when one does not fit before the end of the buffer the writer
+    // also claims the tail and fills it with a padding record the reader skips over.
+    // Capping records at half the capacity guarantees the pair fits once drained.
+    bool try_write(const void* data, size_t length) throw (ring_buffer_invalid_address_exception) {
+        auto result = false;
+
+        if (nullptr != data) {
+            auto size = record_size(length);
+
+            if (2 * size <= capacity) {
+                auto position = _write.load(std::memory_order_relaxed);
+                size_t tail, claimed;
+
+                do {
+                    tail = capacity - (position & mask);
+                    claimed = (tail < size) ? tail + size : size;
+
+                    if (claimed > capacity - (position - _read.load(std::memory_order_acquire)))
+                        return false;
+                } while (not _write.compare_exchange_weak(position, position + claimed, std::memory_order_relaxed));
+
+                if (tail < size) {
+                    header_at(position).store((tail << flag_bits) | padding | committed, std::memory_order_release);
+                    position += tail;
+                }
+
+                memcpy(buffer() + (position & mask) + sizeof(header), data, length);
+                header_at(position).store((length << flag_bits) | committed, std::memory_order_release);
+                result = true;
+            }
+        }
+        else
+            throw ring_buffer_invalid_address_exception{};
+
+        return result;
+    }
+
+
+    void write(const void* data, size_t length) throw (ring_buffer_overflow_exception, ring_buffer_invalid_address_exception) {
+        if (not try_write(data, length))
+            throw ring_buffer_overflow_exception{};
+    }
+
+
+    size_t drain(const ring_buffer_record_handler& handler) {
+        auto start = _read.load(std::memory_order_relaxed), position = start;
+        size_t count = 0;
+
+        // Consumed space is zeroed before it is handed back so that stale payload bytes
+        // can never be mistaken for the header of a record that is still being copied
+        auto release = [&]() {
+            auto offset = start & mask, length = position - start, size = std::min(length, capacity - offset);
+
+            memset(buffer() + offset, 0, size);
+            memset(buffer(), 0, length - size);
+            _read.store(position, std::memory_order_release);
+        };
+
+        try {
+            for (auto value = header_at(position).load(std::memory_order_acquire); value & committed; value = header_at(position).load(std::memory_order_acquire)) {
+                auto length = value >> flag_bits;
+
+                if (value & padding)
+                    position += length;
+                else {
+                    handler(buffer() + (position & mask) + sizeof(header), length);
+                    position += record_size(length);
+                    count++;
+                }
+
+                // Never run a full lap ahead of the batch that is about to be released
+                if (position - start == capacity)
+                    break;
+            }
+        } catch (...) {
+            release();
+            throw;
+        }
+
+        release();
+
+        return count;
+    }
+
+
+    void get_available(size_t& read, size_t& write) throw () {
+        // Claimed space counts as readable even if its writer has not committed it yet
+        auto consumed = _read.load(std::memory_order_acquire);
+
+        read = _write.load(std::memory_order_acquire) - consumed;
+        write = capacity - read;
+    }
+};
+
+
+mpsc_ring_buffer::mpsc_ring_buffer(size_t capacity) throw (ring_buffer_out_of_memory_exception) : implementation(new mpsc_ring_buffer_implementation{capacity}) { }
+void mpsc_ring_buffer::write(const void* data, size_t length) throw (ring_buffer_overflow_exception, ring_buffer_invalid_address_exception) { implementation->write(data, length); }
+bool mpsc_ring_buffer::try_write(const void* data, size_t length) throw (ring_buffer_invalid_address_exception) { return implementation->try_write(data, length); }
+size_t mpsc_ring_buffer::drain(const ring_buffer_record_handler& handler) { return implementation->drain(handler); }
+void mpsc_ring_buffer::get_available(size_t& read, size_t& write) throw () { implementation->get_available(read, write); }
+mpsc_ring_buffer::~mpsc_ring_buffer() throw () { }
@@ -0,0 +1,51 @@
+/*
+    Copyright 2011 Emilio Guijarro
+
+    This file is part of the Ring Buffer library.
+
+    The Ring Buffer library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Ring Buffer library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Ring Buffer library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+
+#include "ring_buffer.hpp"
+
+
+// Ring of variable-length records for many writer threads and a single reader thread.
+// Writers claim space with an atomic update of the write cursor, copy outside of any
+// lock and publish through a per-record commit flag, so a slow writer only delays the
+// reader at its own record. The reader drains every committed record in one batch
+// and hands each one to the handler in place. Capacity is rounded up to a power of
+// two; every record takes its length plus an 8 byte header, rounded up to 8 bytes,
+// and may use at most half of the capacity.
+class mpsc_ring_buffer {
+private:
+    class mpsc_ring_buffer_implementation; std::unique_ptr<mpsc_ring_buffer_implementation> implementation;
+
+
+public:
+    typedef std::function<void (const void* data, size_t length)> ring_buffer_record_handler;
+
+
+    mpsc_ring_buffer(size_t capacity) throw (ring_buffer_out_of_memory_exception);
+    mpsc_ring_buffer(const mpsc_ring_buffer& other) = delete;
+    mpsc_ring_buffer& operator=(const mpsc_ring_buffer& other) = delete;
+    void write(const void* data, size_t length) throw (ring_buffer_overflow_exception, ring_buffer_invalid_address_exception);
+    bool try_write(const void* data, size_t length) throw (ring_buffer_invalid_address_exception);
+    size_t drain(const ring_buffer_record_handler& handler);
+    void get_available(size_t& read, size_t& write) throw ();
+    ~mpsc_ring_buffer() throw ();
+};
@@ -19,8 +19,21 @@
 
 
 #include "ring_buffer.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
 #include <cstring>
+#include <initializer_list>
 #include <mutex>
+#include <new>
+#include <thread>
+#include <utility>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 
 struct ring_buffer::ring_buffer_implementation {
@@ -29,36 +42,418 @@ struct ring_buffer::ring_buffer_implementation {
         size_t threshold;
     };
 
+    struct _event {
+        int fd;
+        size_t threshold;
+        bool signalled;
+    };
+
+
+    static const size_t cache_line_size = 64;
+    static const size_t hybrid_spins = 1000, hybrid_yields = 100;
+    static const size_t huge_page_size = 2 * 1024 * 1024, max_numa_nodes = 1024;
+
 
-    std::unique_ptr<char[]> buffer; 
-    size_t capacity, _read, _write;
-    _callback read_callback, write_callback;
+    // Producer and consumer state sit on cache lines of their own, apart from the shared
+    // configuration; the padding works without relying on over-aligned allocation
+    char* buffer;
+    size_t capacity, mask, mapped;
+    bool mirrored;
+    ring_buffer_attributes attributes;
     std::recursive_mutex mutex;
+    std::condition_variable_any readable, writable;
+    size_t firing; // Callbacks running, which can only be on the thread holding the mutex
+    char _padding0[cache_line_size];
+    size_t _write, reserved, read_waiters;
+    _callback read_callback;
+    _event read_event;
+    char _padding1[cache_line_size];
+    size_t _read, peeked, write_waiters;
+    _callback write_callback;
+    _event write_event;
+    char _padding2[cache_line_size];
 
 
     inline size_t ring_buffer_readable() { return _write - _read; }
     inline size_t ring_buffer_writable() { return capacity - ring_buffer_readable(); }
+    inline size_t ring_buffer_offset(size_t position) { return (0 != mask) ? (position & mask) : (position % capacity); }
+
+
+    static size_t round_up_power_of_two(size_t value) throw (ring_buffer_out_of_memory_exception) {
+        size_t result = 1;
+
+        while (result < value) {
+            // Doubling past the top bit wraps to zero; nothing that large can be allocated anyway
+            if (0 == (result << 1))
+                throw ring_buffer_out_of_memory_exception{};
+
+            result <<= 1;
+        }
+
+        return result;
+    }
 
 
-    ring_buffer_implementation(size_t capacity) throw (ring_buffer_out_of_memory_exception) : capacity(capacity), _read(0), _write(0) {
+    ring_buffer_implementation(size_t capacity, const ring_buffer_attributes& attributes) throw (std::system_error, ring_buffer_out_of_memory_exception) : buffer(nullptr), capacity(attributes.power_of_two ? round_up_power_of_two(capacity) : capacity), mapped(0), mirrored(attributes.mirrored), attributes(attributes), firing(0), _write(0), reserved(0), read_waiters(0), read_event{-1, 0, false}, _read(0), peeked(0), write_waiters(0), write_event{-1, 0, false} {
+        allocate_buffer();
+    }
+
+
+    // Builds the implementation in memory from the attributes' resource, if they name one
+    template <typename... Arguments>
+    static ring_buffer_implementation* create(ring_buffer_memory_resource* resource, Arguments&&... arguments) throw (std::system_error, ring_buffer_out_of_memory_exception) {
+        void* memory = nullptr;
+
         try {
-            buffer.reset(new char[capacity]);
-        } catch (std::bad_alloc) {
+            memory = resource ? resource->allocate(sizeof(ring_buffer_implementation), alignof(ring_buffer_implementation)) : ::operator new(sizeof(ring_buffer_implementation));
+        } catch (std::bad_alloc&) {
+        }
+
+        if (nullptr == memory)
             throw ring_buffer_out_of_memory_exception{};
+
+        try {
+            return new (memory) ring_buffer_implementation{std::forward<Arguments>(arguments)...};
+        } catch (...) {
+            release(resource, memory);
+            throw;
         }
     }
 
 
+    static void release(ring_buffer_memory_resource* resource, void* memory) {
+        if (resource)
+            resource->deallocate(memory, sizeof(ring_buffer_implementation), alignof(ring_buffer_implementation));
+        else
+            ::operator delete(memory);
+    }
+
+
     // TBD: implement using constructor delegation (N1986)
-    ring_buffer_implementation(ring_buffer_implementation* other) throw (std::system_error, ring_buffer_out_of_memory_exception) : capacity(other->capacity), _read(other->_read), _write(other->_write), read_callback(other->read_callback), write_callback(other->write_callback) {
+    ring_buffer_implementation(ring_buffer_implementation* other) throw (std::system_error, ring_buffer_out_of_memory_exception) : buffer(nullptr), capacity(other->capacity), mapped(0), mirrored(other->mirrored), attributes(other->attributes), firing(0), _write(other->_write), reserved(0), read_waiters(0), read_callback(other->read_callback), read_event{-1, 0, false}, _read(other->_read), peeked(0), write_waiters(0), write_callback(other->write_callback), write_event{-1, 0, false} {
         std::lock_guard<std::recursive_mutex> lock{other->mutex};
 
-        try {
-            buffer.reset(new char[capacity]);
-            memcpy(buffer.get(), other->buffer.get(), capacity);
-        } catch (std::bad_alloc) {
+        allocate_buffer();
+
+        // Only the live region is copied, at the same offsets so the cursors stay valid
+        auto position = _read;
+
+        for (auto& span : other->get_spans(_read, ring_buffer_readable())) {
+            copy_to(position, span.data, span.length);
+            position += span.length;
+        }
+    }
+
+
+    ~ring_buffer_implementation() {
+        release_buffer();
+
+        for (auto fd : { read_event.fd, write_event.fd })
+            if (-1 != fd)
+                close(fd);
+    }
+
+
+    static size_t round_up(size_t value, size_t unit) {
+        return std::max(unit, (value + unit - 1) / unit * unit);
+    }
+
+
+    // Storage pages are only allocated when first touched, so the NUMA policy and huge page
+    // advice go in before anything else; locking and prefaulting then fault everything in
+    // up front instead of on the first writes
+    void place_buffer(char* base, size_t length) throw (std::system_error) {
+        auto node = attributes.numa_node;
+        unsigned int cpu, local;
+
+        // Advice only: hugetlb mappings reject it and that is fine
+        if (attributes.huge_pages)
+            madvise(base, length, MADV_HUGEPAGE);
+
+        if (ring_buffer_attributes::numa_local == node) {
+            if (0 != getcpu(&cpu, &local))
+                throw std::system_error{errno, std::system_category()};
+
+            node = local;
+        }
+
+        if (0 <= node) {
+            std::array<unsigned long, max_numa_nodes / (8 * sizeof(unsigned long))> nodes{};
+
+            if (static_cast<size_t>(node) >= max_numa_nodes)
+                throw std::system_error{EINVAL, std::system_category()};
+
+            nodes[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+
+            if (0 != syscall(SYS_mbind, base, length, MPOL_BIND, nodes.data(), max_numa_nodes + 1, 0))
+                throw std::system_error{errno, std::system_category()};
+        }
+
+        if (attributes.locked and (0 != mlock(base, length)))
+            throw std::system_error{errno, std::system_category()};
+
+        if (attributes.prefault)
+            for (size_t i = 0; i < length; i += static_cast<size_t>(sysconf(_SC_PAGESIZE)))
+                reinterpret_cast<volatile char*>(base)[i] = 0;
+    }
+
+
+    // Maps a memory file of the given size twice back to back. Hugetlb files can only be
+    // mapped at huge page boundaries, so the reservation is aligned and then trimmed.
+    void map_mirrored(size_t size, size_t alignment, unsigned int memfd_flags) throw (std::system_error, ring_buffer_out_of_memory_exception) {
+        auto fd = memfd_create("ring_buffer", MFD_CLOEXEC | memfd_flags);
+
+        if (-1 == fd)
+            throw std::system_error{errno, std::system_category()};
+
+        if (0 != ftruncate(fd, size)) {
+            auto error = errno;
+
+            close(fd);
+            throw std::system_error{error, std::system_category()};
+        }
+
+        auto reservation = reinterpret_cast<char*>(mmap(nullptr, 2 * size + alignment, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0)), base = reservation;
+
+        if (MAP_FAILED != reservation) {
+            base = reinterpret_cast<char*>((reinterpret_cast<uintptr_t>(reservation) + alignment - 1) / alignment * alignment);
+
+            if (base > reservation)
+                munmap(reservation, base - reservation);
+
+            munmap(base + 2 * size, reservation + alignment - base);
+
+            if ((MAP_FAILED == mmap(base, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0)) or (MAP_FAILED == mmap(base + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0))) {
+                munmap(base, 2 * size);
+                base = reinterpret_cast<char*>(MAP_FAILED);
+            }
+        }
+
+        close(fd);
+
+        if (MAP_FAILED == base)
             throw ring_buffer_out_of_memory_exception{};
+
+        buffer = base;
+        capacity = size;
+    }
+
+
+    void allocate_buffer() throw (std::system_error, ring_buffer_out_of_memory_exception) {
+        if (mirrored) {
+            auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+
+            // Without a huge page pool fall back to regular pages and leave it to the advice
+            if (attributes.huge_pages) {
+                try {
+                    map_mirrored(round_up(capacity, huge_page_size), huge_page_size, MFD_HUGETLB);
+                } catch (std::system_error&) {
+                } catch (ring_buffer_out_of_memory_exception&) {
+                }
+            }
+
+            // Both views share the same pages, so the size has to be a whole number of them
+            if (nullptr == buffer)
+                map_mirrored(round_up(capacity, page), page, 0);
+        }
+        else if (attributes.huge_pages or attributes.locked or attributes.prefault or (ring_buffer_attributes::numa_any != attributes.numa_node)) {
+            auto page = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+            auto base = reinterpret_cast<char*>(MAP_FAILED);
+
+            // Storage with placement attributes comes straight from mmap instead of new
+            if (attributes.huge_pages)
+                base = reinterpret_cast<char*>(mmap(nullptr, mapped = round_up(capacity, huge_page_size), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0));
+
+            if (MAP_FAILED == base)
+                base = reinterpret_cast<char*>(mmap(nullptr, mapped = round_up(capacity, page), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+
+            if (MAP_FAILED == base)
+                throw ring_buffer_out_of_memory_exception{};
+
+            buffer = base;
+        }
+        else {
+            try {
+                buffer = attributes.resource ? reinterpret_cast<char*>(attributes.resource->allocate(capacity, cache_line_size)) : new char[capacity];
+            } catch (std::bad_alloc) {
+                throw ring_buffer_out_of_memory_exception{};
+            }
+
+            if (nullptr == buffer)
+                throw ring_buffer_out_of_memory_exception{};
+        }
+
+        if (mirrored or (0 != mapped)) {
+            try {
+                place_buffer(buffer, mirrored ? 2 * capacity : mapped);
+            } catch (std::system_error&) {
+                release_buffer();
+                throw;
+            }
         }
+
+        // Any power of two capacity (whether requested or not) takes the masking fast path
+        mask = (0 == (capacity & (capacity - 1))) ? capacity - 1 : 0;
+    }
+
+
+    void release_buffer() {
+        if (mirrored)
+            munmap(buffer, 2 * capacity);
+        else if (0 != mapped)
+            munmap(buffer, mapped);
+        else if (attributes.resource)
+            attributes.resource->deallocate(buffer, capacity, cache_line_size);
+        else
+            delete[] buffer;
+    }
+
+
+    // A mirrored buffer exposes every region as a single span, otherwise copies may wrap once
+    void copy_to(size_t position, const void* data, size_t length) {
+        auto target = ring_buffer_offset(position);
+
+        if (mirrored)
+            memcpy(buffer + target, data, length);
+        else {
+            auto size = std::min(length, capacity - target);
+
+            memcpy(buffer + target, data, size);
+
+            if (size < length)
+                memcpy(buffer, reinterpret_cast<const char*>(data) + size, length - size);
+        }
+    }
+
+
+    void copy_from(size_t position, void* data, size_t length) {
+        auto target = ring_buffer_offset(position);
+
+        if (mirrored)
+            memcpy(data, buffer + target, length);
+        else {
+            auto size = std::min(length, capacity - target);
+
+            memcpy(data, buffer + target, size);
+
+            if (size < length)
+                memcpy(reinterpret_cast<char*>(data) + size, buffer, length - size);
+        }
+    }
+
+
+    // Describes the region starting at position as up to two spans (the second one empty unless it wraps)
+    std::array<ring_buffer_span, 2> get_spans(size_t position, size_t length) {
+        auto target = ring_buffer_offset(position), size = mirrored ? length : std::min(length, capacity - target);
+
+        return {{ { buffer + target, size }, { buffer, length - size } }};
+    }
+
+
+    // Events are edge-triggered: the eventfd is signalled once when the level reaches the
+    // threshold and rearmed only after the level has dropped below it again
+    static void update_event(_event& event, size_t level) {
+        if (level < event.threshold)
+            event.signalled = false;
+        else if ((-1 != event.fd) and not event.signalled) {
+            uint64_t value = 1;
+
+            event.signalled = (sizeof(value) == ::write(event.fd, &value, sizeof(value)));
+        }
+    }
+
+
+    void update_events() {
+        update_event(read_event, ring_buffer_readable());
+        update_event(write_event, ring_buffer_writable());
+    }
+
+
+    // The descriptor belongs to the ring; setting it again only changes the threshold
+    int set_eventfd(_event& event, size_t threshold) throw (std::system_error) {
+        std::lock_guard<std::recursive_mutex> lock{mutex};
+
+        if ((-1 == event.fd) and (-1 == (event.fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))))
+            throw std::system_error{errno, std::system_category()};
+
+        event.threshold = threshold;
+        event.signalled = false;
+        update_events();
+
+        return event.fd;
+    }
+
+
+    int set_read_eventfd(size_t threshold) throw (std::system_error) { return set_eventfd(read_event, threshold); }
+    int set_write_eventfd(size_t threshold) throw (std::system_error) { return set_eventfd(write_event, threshold); }
+
+
+    // Besides running the callback, wakes parked waiters; with nobody parked the
+    // notification is skipped, so the common case never enters the kernel
+    void fire_read_callback() {
+        update_events();
+
+        if (0 != read_waiters)
+            readable.notify_all();
+
+        if (read_callback.callback and (ring_buffer_readable() >= read_callback.threshold)) {
+            firing++;
+            read_callback.callback();
+            firing--;
+        }
+    }
+
+
+    void fire_write_callback() {
+        update_events();
+
+        if (0 != write_waiters)
+            writable.notify_all();
+
+        if (write_callback.callback and (ring_buffer_writable() >= write_callback.threshold)) {
+            firing++;
+            write_callback.callback();
+            firing--;
+        }
+    }
+
+
+    // Retries attempt until it succeeds or the timeout expires, waiting in between as
+    // the strategy says. Parked threads are counted in waiters while they sleep. A
+    // timeout too long to add to the clock (nanoseconds::max(), say) waits forever.
+    // Waiting from a callback is refused: the caller already holds the mutex, which
+    // parking only releases one level of, so nobody could ever make progress for it.
+    template <typename Attempt>
+    bool wait(Attempt attempt, std::condition_variable_any& condition, size_t& waiters, std::chrono::nanoseconds timeout, ring_buffer_wait_strategy strategy) {
+        auto now = std::chrono::steady_clock::now();
+        auto deadline = (timeout < std::chrono::steady_clock::time_point::max() - now) ? now + timeout : std::chrono::steady_clock::time_point::max();
+
+        {
+            std::lock_guard<std::recursive_mutex> lock{mutex};
+
+            if (0 < firing)
+                throw std::system_error{std::make_error_code(std::errc::resource_deadlock_would_occur)};
+        }
+
+        auto result = attempt();
+
+        for (size_t rounds = 0; not result and (std::chrono::steady_clock::now() < deadline); rounds++) {
+            if ((ring_buffer_wait_strategy::park == strategy) or ((ring_buffer_wait_strategy::hybrid == strategy) and (rounds >= hybrid_spins + hybrid_yields))) {
+                std::unique_lock<std::recursive_mutex> lock{mutex};
+
+                waiters++;
+                result = condition.wait_until(lock, deadline, attempt);
+                waiters--;
+                break;
+            }
+
+            if ((ring_buffer_wait_strategy::yield == strategy) or ((ring_buffer_wait_strategy::hybrid == strategy) and (rounds >= hybrid_spins)))
+                std::this_thread::yield();
+
+            result = attempt();
+        }
+
+        return result;
     }
 
 
@@ -78,55 +473,287 @@ struct ring_buffer::ring_buffer_implementation {
     }
 
 
-    void write(const void* data, size_t length) throw (std::system_error, ring_buffer_overflow_exception, ring_buffer_invalid_address_exception) {
+    // Validates a scatter/gather vector and returns the number of bytes it describes
+    static size_t vector_length(const iovec* vector, int count) throw (ring_buffer_invalid_address_exception) {
+        size_t result = 0;
+
+        if ((0 > count) or ((nullptr == vector) and (0 < count)))
+            throw ring_buffer_invalid_address_exception{};
+
+        for (auto segment = vector; segment != vector + count; segment++)
+            if ((nullptr != segment->iov_base) or (0 == segment->iov_len))
+                result += segment->iov_len;
+            else
+                throw ring_buffer_invalid_address_exception{};
+
+        return result;
+    }
+
+
+    // All segments move under one lock and callbacks fire once for the whole vector
+    void writev(const iovec* vector, int count) throw (std::system_error, ring_buffer_overflow_exception, ring_buffer_invalid_address_exception) {
+        auto length = vector_length(vector, count);
+        std::lock_guard<std::recursive_mutex> lock{mutex};
+
+        if (ring_buffer_writable() >= length) {
+            auto position = _write;
+
+            for (auto segment = vector; segment != vector + count; position += segment->iov_len, segment++)
+                copy_to(position, segment->iov_base, segment->iov_len);
+
+            _write = position;
+            reserved = 0;
+            fire_read_callback();
+        }
+        else
+            throw ring_buffer_overflow_exception{};
+    }
+
+
+    void readv(const iovec* vector, int count) throw (std::system_error, ring_buffer_underflow_exception, ring_buffer_invalid_address_exception) {
+        auto length = vector_length(vector, count);
+        std::lock_guard<std::recursive_mutex> lock{mutex};
+
+        if (ring_buffer_readable() >= length) {
+            auto position = _read;
+
+            for (auto segment = vector; segment != vector + count; position += segment->iov_len, segment++)
+                copy_from(position, segment->iov_base, segment->iov_len);
+
+            _read = position;
+            peeked = 0;
+            fire_write_callback();
+        }
+        else
+            throw ring_buffer_underflow_exception{};
+    }
+
+
+    bool try_write(const void* data, size_t length) throw (std::system_error, ring_buffer_invalid_address_exception) {
+        auto result = false;
+
         if (0 != data) { // TBD: use nullptr
             std::lock_guard<std::recursive_mutex> lock{mutex};
 
             if (ring_buffer_writable() >= length) {
-                auto left = length;
+                copy_to(_write, data, length);
+                _write += length;
+                reserved = 0;
+                fire_read_callback();
+                result = true;
+            }
+        }
+        else
+            throw ring_buffer_invalid_address_exception{};
+
+        return result;
+    }
+
+
+    void write(const void* data, size_t length) throw (std::system_error, ring_buffer_overflow_exception, ring_buffer_invalid_address_exception) {
+        if (not try_write(data, length))
+            throw ring_buffer_overflow_exception{};
+    }
 
-                do {
-                    auto target = _write % capacity, size = std::min(left, capacity - target);
 
-                    memcpy(buffer.get() + target, reinterpret_cast<const char*>(data) + length - left, size);
-                    left -= size;
-                    _write += size;
-                } while (left > 0);
+    bool try_read(void* data, size_t length) throw (std::system_error, ring_buffer_invalid_address_exception) {
+        auto result = false;
+
+        if (0 != data) { // TBD: use nullptr
+            std::lock_guard<std::recursive_mutex> lock{mutex};
 
-                if (read_callback.callback and (ring_buffer_readable() >= read_callback.threshold))
-                    read_callback.callback();
+            if (ring_buffer_readable() >= length) {
+                copy_from(_read, data, length);
+                _read += length;
+                peeked = 0;
+                fire_write_callback();
+                result = true;
             }
-            else
-                throw ring_buffer_overflow_exception{};
         }
         else
             throw ring_buffer_invalid_address_exception{};
+
+        return result;
     }
 
 
     void read(void* data, size_t length) throw (std::system_error, ring_buffer_underflow_exception, ring_buffer_invalid_address_exception) {
+        if (not try_read(data, length))
+            throw ring_buffer_underflow_exception{};
+    }
+
+
+    // Transfers as much as fits (possibly nothing) and reports the count, like POSIX write
+    size_t write_some(const void* data, size_t length) throw (std::system_error, ring_buffer_invalid_address_exception) {
+        size_t result = 0;
+
         if (0 != data) { // TBD: use nullptr
             std::lock_guard<std::recursive_mutex> lock{mutex};
 
-            if (ring_buffer_readable() >= length) {
-                auto left = length;
+            if (0 < (result = std::min(length, ring_buffer_writable()))) {
+                copy_to(_write, data, result);
+                _write += result;
+                reserved = 0;
+                fire_read_callback();
+            }
+        }
+        else
+            throw ring_buffer_invalid_address_exception{};
+
+        return result;
+    }
 
-                do {
-                    auto target = _read % capacity, size = std::min(left, capacity - target);
 
-                    memcpy(reinterpret_cast<char*>(data) + length - left, buffer.get() + target, size);
-                    left -= size;
-                    _read += size;
-                } while (left > 0);
+    size_t read_some(void* data, size_t length) throw (std::system_error, ring_buffer_invalid_address_exception) {
+        size_t result = 0;
 
-                if (write_callback.callback and (ring_buffer_writable() >= write_callback.threshold))
-                    write_callback.callback();
+        if (0 != data) { // TBD: use nullptr
+            std::lock_guard<std::recursive_mutex> lock{mutex};
+
+            if (0 < (result = std::min(length, ring_buffer_readable()))) {
+                copy_from(_read, data, result);
+                _read += result;
+                peeked = 0;
+                fire_write_callback();
             }
-            else
-                throw ring_buffer_underflow_exception{};
         }
         else
             throw ring_buffer_invalid_address_exception{};
+
+        return result;
+    }
+
+
+    bool write_wait(const void* data, size_t length, std::chrono::nanoseconds timeout, ring_buffer_wait_strategy strategy) throw (std::system_error, ring_buffer_invalid_address_exception) {
+        // A write longer than the capacity could never succeed, so do not wait for it
+        return (length <= capacity) ? wait([&]() { return try_write(data, length); }, writable, write_waiters, timeout, strategy) : try_write(data, length);
+    }
+
+
+    bool read_wait(void* data, size_t length, std::chrono::nanoseconds timeout, ring_buffer_wait_strategy strategy) throw (std::system_error, ring_buffer_invalid_address_exception) {
+        return (length <= capacity) ? wait([&]() { return try_read(data, length); }, readable, read_waiters, timeout, strategy) : try_read(data, length);
+    }
+
+
+    // Turns the spans of a region into the iovec array the scatter/gather syscalls take
+    int get_vector(size_t position, size_t length, std::array<iovec, 2>& vector) {
+        auto spans = get_spans(position, length);
+
+        vector = {{ { spans[0].data, spans[0].length }, { spans[1].data, spans[1].length } }};
+
+        return (0 < spans[1].length) ? 2 : 1;
+    }
+
+
+    // Reads straight from the descriptor into the free space, with no intermediate copy.
+    // The lock is held across the syscall, so fd should be non-blocking. A descriptor with
+    // nothing ready throws EAGAIN, so zero bytes with space available means end of file.
+    size_t fill_from_fd(int fd, size_t max) throw (std::system_error) {
+        std::lock_guard<std::recursive_mutex> lock{mutex};
+        std::array<iovec, 2> vector;
+        auto length = std::min(max, ring_buffer_writable());
+        ssize_t result = 0;
+
+        if ((0 < length) and (0 > (result = ::readv(fd, vector.data(), get_vector(_write, length, vector)))))
+            throw std::system_error{errno, std::system_category()};
+
+        if (0 < result) {
+            _write += result;
+            reserved = 0;
+            fire_read_callback();
+        }
+
+        return result;
+    }
+
+
+    size_t drain_to_fd(int fd, size_t max) throw (std::system_error) {
+        std::lock_guard<std::recursive_mutex> lock{mutex};
+        std::array<iovec, 2> vector;
+        auto length = std::min(max, ring_buffer_readable());
+        ssize_t result = 0;
+
+        if ((0 < length) and (0 > (result = ::writev(fd, vector.data(), get_vector(_read, length, vector)))))
+            throw std::system_error{errno, std::system_category()};
+
+        if (0 < result) {
+            _read += result;
+            peeked = 0;
+            fire_write_callback();
+        }
+
+        return result;
+    }
+
+
+    // Any other write before the commit cancels the reservation, whose spans it may overlap
+    std::array<ring_buffer_span, 2> reserve(size_t length) throw (std::system_error, ring_buffer_overflow_exception) {
+        std::lock_guard<std::recursive_mutex> lock{mutex};
+
+        if (ring_buffer_writable() >= length) {
+            reserved = length;
+
+            return get_spans(_write, length);
+        }
+        else
+            throw ring_buffer_overflow_exception{};
+    }
+
+
+    // Committing less than the reservation publishes a prefix and drops the rest
+    void commit(size_t length) throw (std::system_error, ring_buffer_overflow_exception) {
+        std::lock_guard<std::recursive_mutex> lock{mutex};
+
+        if (reserved >= length) {
+            _write += length;
+            reserved = 0;
+            fire_read_callback();
+        }
+        else
+            throw ring_buffer_overflow_exception{};
+    }
+
+
+    // Any other read before the consume cancels the peek, whose spans it may have released
+    std::array<ring_buffer_span, 2> peek() throw (std::system_error) {
+        std::lock_guard<std::recursive_mutex> lock{mutex};
+
+        peeked = ring_buffer_readable();
+
+        return get_spans(_read, peeked);
+    }
+
+
+    // Consuming less than was peeked releases a prefix and leaves the rest readable
+    void consume(size_t length) throw (std::system_error, ring_buffer_underflow_exception) {
+        std::lock_guard<std::recursive_mutex> lock{mutex};
+
+        if (peeked >= length) {
+            _read += length;
+            peeked = 0;
+            fire_write_callback();
+        }
+        else
+            throw ring_buffer_underflow_exception{};
+    }
+
+
+    void skip(size_t length) throw (std::system_error, ring_buffer_underflow_exception) {
+        std::lock_guard<std::recursive_mutex> lock{mutex};
+
+        if (ring_buffer_readable() >= length) {
+            _read += length;
+            peeked = 0;
+            fire_write_callback();
+        }
+        else
+            throw ring_buffer_underflow_exception{};
+    }
+
+
+    // The whole data area (both views when mirrored), e.g. to register it with the kernel
+    ring_buffer_span get_storage() throw () {
+        return { buffer, mirrored ? 2 * capacity : capacity };
     }
 
 
@@ -139,12 +766,35 @@ struct ring_buffer::ring_buffer_implementation {
 };
 
 
-ring_buffer::ring_buffer(size_t capacity) throw (std::system_error, ring_buffer_out_of_memory_exception) : implementation(new ring_buffer_implementation{capacity}) { }
-ring_buffer::ring_buffer(ring_buffer& other) throw (std::system_error, ring_buffer_out_of_memory_exception) : implementation(new ring_buffer_implementation{other.implementation.get()}) { }
-ring_buffer& ring_buffer::operator=(ring_buffer& other) throw (std::system_error, ring_buffer_out_of_memory_exception) { implementation.reset(new ring_buffer_implementation{other.implementation.get()}); return *this; }
+ring_buffer::ring_buffer(size_t capacity) throw (std::system_error, ring_buffer_out_of_memory_exception) : implementation(ring_buffer_implementation::create(nullptr, capacity, ring_buffer_attributes{})) { }
+ring_buffer::ring_buffer(size_t capacity, const ring_buffer_attributes& attributes) throw (std::system_error, ring_buffer_out_of_memory_exception) : implementation(ring_buffer_implementation::create(attributes.resource, capacity, attributes)) { }
+ring_buffer::ring_buffer(ring_buffer& other) throw (std::system_error, ring_buffer_out_of_memory_exception) : implementation(ring_buffer_implementation::create(other.implementation->attributes.resource, other.implementation.get())) { }
+ring_buffer& ring_buffer::operator=(ring_buffer& other) throw (std::system_error, ring_buffer_out_of_memory_exception) { implementation.reset(ring_buffer_implementation::create(other.implementation->attributes.resource, other.implementation.get())); return *this; }
+ring_buffer::ring_buffer(ring_buffer&& other) throw () : implementation(std::move(other.implementation)) { }
+ring_buffer& ring_buffer::operator=(ring_buffer&& other) throw () { implementation = std::move(other.implementation); return *this; }
+void ring_buffer::swap(ring_buffer& other) throw () { implementation.swap(other.implementation); }
 void ring_buffer::set_read_callback(ring_buffer_callback callback, size_t threshold) throw (std::system_error) { implementation->set_read_callback(callback, threshold); }
 void ring_buffer::set_write_callback(ring_buffer_callback callback, size_t threshold) throw (std::system_error) { implementation->set_write_callback(callback, threshold); }
+int ring_buffer::set_read_eventfd(size_t threshold) throw (std::system_error) { return implementation->set_read_eventfd(threshold); }
+int ring_buffer::set_write_eventfd(size_t threshold) throw (std::system_error) { return implementation->set_write_eventfd(threshold); }
 void ring_buffer::write(const void* data, size_t length) throw (std::system_error, ring_buffer_overflow_exception, ring_buffer_invalid_address_exception) { implementation->write(data, length); }
 void ring_buffer::read(void* data, size_t length) throw (std::system_error, ring_buffer_underflow_exception, ring_buffer_invalid_address_exception) { implementation->read(data, length); }
+void ring_buffer::writev(const iovec* vector, int count) throw (std::system_error, ring_buffer_overflow_exception, ring_buffer_invalid_address_exception) { implementation->writev(vector, count); }
+void ring_buffer::readv(const iovec* vector, int count) throw (std::system_error, ring_buffer_underflow_exception, ring_buffer_invalid_address_exception) { implementation->readv(vector, count); }
+bool ring_buffer::try_write(const void* data, size_t length) throw (std::system_error, ring_buffer_invalid_address_exception) { return implementation->try_write(data, length); }
+bool ring_buffer::try_read(void* data, size_t length) throw (std::system_error, ring_buffer_invalid_address_exception) { return implementation->try_read(data, length); }
+size_t ring_buffer::write_some(const void* data, size_t length) throw (std::system_error, ring_buffer_invalid_address_exception) { return implementation->write_some(data, length); }
+size_t ring_buffer::read_some(void* data, size_t length) throw (std::system_error, ring_buffer_invalid_address_exception) { return implementation->read_some(data, length); }
+bool ring_buffer::write_wait(const void* data, size_t length, std::chrono::nanoseconds timeout, ring_buffer_wait_strategy strategy) throw (std::system_error, ring_buffer_invalid_address_exception) { return implementation->write_wait(data, length, timeout, strategy); }
+bool ring_buffer::read_wait(void* data, size_t length, std::chrono::nanoseconds timeout, ring_buffer_wait_strategy strategy) throw (std::system_error, ring_buffer_invalid_address_exception) { return implementation->read_wait(data, length, timeout, strategy); }
+size_t ring_buffer::fill_from_fd(int fd, size_t max) throw (std::system_error) { return implementation->fill_from_fd(fd, max); }
+size_t ring_buffer::drain_to_fd(int fd, size_t max) throw (std::system_error) { return implementation->drain_to_fd(fd, max); }
+std::array<ring_buffer_span, 2> ring_buffer::reserve(size_t length) throw (std::system_error, ring_buffer_overflow_exception) { return implementation->reserve(length); }
+void ring_buffer::commit(size_t length) throw (std::system_error, ring_buffer_overflow_exception) { implementation->commit(length); }
+std::array<ring_buffer_span, 2> ring_buffer::peek() throw (std::system_error) { return implementation->peek(); }
+void ring_buffer::consume(size_t length) throw (std::system_error, ring_buffer_underflow_exception) { implementation->consume(length); }
+void ring_buffer::skip(size_t length) throw (std::system_error, ring_buffer_underflow_exception) { implementation->skip(length); }
 void ring_buffer::get_available(size_t& read, size_t& write) throw (std::system_error) { implementation->get_available(read, write); }
-ring_buffer::~ring_buffer() throw (std::system_error) { }
+ring_buffer_span ring_buffer::get_storage() throw () { return implementation->get_storage(); }
+ring_buffer::~ring_buffer() throw () { }
+void ring_buffer::ring_buffer_deleter::operator()(ring_buffer_implementation* implementation) const { auto resource = implementation->attributes.resource; implementation->~ring_buffer_implementation(); ring_buffer_implementation::release(resource, implementation); }
@@ -21,20 +21,64 @@
 #pragma once
 
 
+#include <array>
+#include <chrono>
 #include <functional>
 #include <memory>
 #include <system_error>
+#include <sys/uio.h>
 
 
 struct ring_buffer_exception { };
 struct ring_buffer_invalid_address_exception : ring_buffer_exception { };
+struct ring_buffer_invalid_reader_exception : ring_buffer_exception { };
+struct ring_buffer_lapped_exception : ring_buffer_exception { };
 struct ring_buffer_out_of_memory_exception : ring_buffer_exception { };
 struct ring_buffer_overflow_exception : ring_buffer_exception { };
 struct ring_buffer_underflow_exception : ring_buffer_exception { };
 
+// Source of the implementation object and of storage that is not mapped. It has the
+// shape of std::pmr::memory_resource, which is out of reach before C++17.
+class ring_buffer_memory_resource {
+public:
+    virtual ~ring_buffer_memory_resource() { }
+    virtual void* allocate(size_t bytes, size_t alignment) = 0;
+    virtual void deallocate(void* data, size_t bytes, size_t alignment) = 0;
+};
+
+struct ring_buffer_attributes {
+    static const int numa_any = -1; // Leave page placement to the kernel
+    static const int numa_local = -2; // Bind to the node of the calling CPU, so create the ring from the consumer
+
+
+    bool mirrored; // Map the storage twice back to back (capacity is rounded up to whole pages)
+    bool power_of_two; // Round capacity up to a power of two so positions are masked instead of divided
+    bool huge_pages; // Back the storage with huge pages if the pool has them, otherwise advise transparent huge pages
+    bool locked; // Lock the storage in memory (subject to RLIMIT_MEMLOCK)
+    bool prefault; // Fault every page in at construction rather than on first use
+    int numa_node; // Node to bind the storage to, or numa_any / numa_local
+    ring_buffer_memory_resource* resource; // nullptr for the global heap; must outlive the ring and its copies
+
+
+    ring_buffer_attributes() : mirrored(false), power_of_two(false), huge_pages(false), locked(false), prefault(false), numa_node(numa_any), resource(nullptr) { }
+};
+
+enum class ring_buffer_wait_strategy {
+    spin, // Poll continuously: lowest wake-up latency, burns a core
+    yield, // Poll, giving the processor away between attempts
+    park, // Sleep until the other side makes progress
+    hybrid // Spin briefly, then yield for a while, then park
+};
+
+struct ring_buffer_span {
+    void* data;
+    size_t length;
+};
+
 class ring_buffer {
 private:
-    class ring_buffer_implementation; std::unique_ptr<ring_buffer_implementation> implementation;
+    class ring_buffer_implementation; struct ring_buffer_deleter { void operator()(ring_buffer_implementation* implementation) const; };
+    std::unique_ptr<ring_buffer_implementation, ring_buffer_deleter> implementation;
 
 
 public:
@@ -42,12 +86,37 @@ public:
 
 
     ring_buffer(size_t capacity) throw (std::system_error, ring_buffer_out_of_memory_exception);
+    ring_buffer(size_t capacity, const ring_buffer_attributes& attributes) throw (std::system_error, ring_buffer_out_of_memory_exception);
     ring_buffer(ring_buffer& other) throw (std::system_error, ring_buffer_out_of_memory_exception);
     ring_buffer& operator=(ring_buffer& other) throw (std::system_error, ring_buffer_out_of_memory_exception);
+    ring_buffer(ring_buffer&& other) throw (); // Leaves other empty: it may only be assigned to or destroyed
+    ring_buffer& operator=(ring_buffer&& other) throw ();
+    void swap(ring_buffer& other) throw ();
     void set_read_callback(ring_buffer_callback callback, size_t threshold) throw (std::system_error);
     void set_write_callback(ring_buffer_callback callback, size_t threshold) throw (std::system_error);
+    int set_read_eventfd(size_t threshold) throw (std::system_error);
+    int set_write_eventfd(size_t threshold) throw (std::system_error);
     void write(const void* data, size_t length) throw (std::system_error, ring_buffer_overflow_exception, ring_buffer_invalid_address_exception);
     void read(void* data, size_t length) throw (std::system_error, ring_buffer_underflow_exception, ring_buffer_invalid_address_exception);
+    void writev(const iovec* vector, int count) throw (std::system_error, ring_buffer_overflow_exception, ring_buffer_invalid_address_exception);
+    void readv(const iovec* vector, int count) throw (std::system_error, ring_buffer_underflow_exception, ring_buffer_invalid_address_exception);
+    bool try_write(const void* data, size_t length) throw (std::system_error, ring_buffer_invalid_address_exception);
+    bool try_read(void* data, size_t length) throw (std::system_error, ring_buffer_invalid_address_exception);
+    size_t write_some(const void* data, size_t length) throw (std::system_error, ring_buffer_invalid_address_exception);
+    size_t read_some(void* data, size_t length) throw (std::system_error, ring_buffer_invalid_address_exception);
+    bool write_wait(const void* data, size_t length, std::chrono::nanoseconds timeout, ring_buffer_wait_strategy strategy) throw (std::system_error, ring_buffer_invalid_address_exception);
+    bool read_wait(void* data, size_t length, std::chrono::nanoseconds timeout, ring_buffer_wait_strategy strategy) throw (std::system_error, ring_buffer_invalid_address_exception);
+    size_t fill_from_fd(int fd, size_t max) throw (std::system_error);
+    size_t drain_to_fd(int fd, size_t max) throw (std::system_error);
+    std::array<ring_buffer_span, 2> reserve(size_t length) throw (std::system_error, ring_buffer_overflow_exception);
+    void commit(size_t length) throw (std::system_error, ring_buffer_overflow_exception);
+    std::array<ring_buffer_span, 2> peek() throw (std::system_error);
+    void consume(size_t length) throw (std::system_error, ring_buffer_underflow_exception);
+    void skip(size_t length) throw (std::system_error, ring_buffer_underflow_exception);
     void get_available(size_t& read, size_t& write) throw (std::system_error);
-    ~ring_buffer() throw (std::system_error);
+    ring_buffer_span get_storage() throw ();
+    ~ring_buffer() throw ();
 };
+
+
+inline void swap(ring_buffer& a, ring_buffer& b) throw () { a.swap(b); }
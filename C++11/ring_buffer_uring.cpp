@@ -0,0 +1,257 @@
+/*
+    Copyright 2011 Emilio Guijarro
+
+    This file is part of the Ring Buffer library.
+
+    The Ring Buffer library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Ring Buffer library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Ring Buffer library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "ring_buffer_uring.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+
+struct ring_buffer_uring::ring_buffer_uring_implementation {
+    // At most one fill and one drain per ring can be in flight, as rings only track a
+    // single reservation and a single peek
+    struct _ring {
+        ring_buffer* ring;
+        bool filling, draining;
+    };
+
+
+    std::vector<_ring> rings;
+    int fd;
+    io_uring_params params;
+    char* sq_ring;
+    char* cq_ring;
+    io_uring_sqe* sqes;
+    size_t sq_ring_size, cq_ring_size;
+    unsigned int pending;
+
+
+    // The kernel shares these counters with us, so they are accessed as atomics in place
+    inline std::atomic<unsigned int>& sq_head() { return *reinterpret_cast<std::atomic<unsigned int>*>(sq_ring + params.sq_off.head); }
+    inline std::atomic<unsigned int>& sq_tail() { return *reinterpret_cast<std::atomic<unsigned int>*>(sq_ring + params.sq_off.tail); }
+    inline unsigned int* sq_array() { return reinterpret_cast<unsigned int*>(sq_ring + params.sq_off.array); }
+    inline std::atomic<unsigned int>& cq_head() { return *reinterpret_cast<std::atomic<unsigned int>*>(cq_ring + params.cq_off.head); }
+    inline std::atomic<unsigned int>& cq_tail() { return *reinterpret_cast<std::atomic<unsigned int>*>(cq_ring + params.cq_off.tail); }
+    inline io_uring_cqe* cqes() { return reinterpret_cast<io_uring_cqe*>(cq_ring + params.cq_off.cqes); }
+
+
+    static void check(bool success) throw (std::system_error) {
+        if (not success)
+            throw std::system_error{errno, std::system_category()};
+    }
+
+
+    ring_buffer_uring_implementation(const std::vector<ring_buffer*>& rings, unsigned int entries) throw (std::system_error, ring_buffer_out_of_memory_exception) : fd(-1), sq_ring(reinterpret_cast<char*>(MAP_FAILED)), cq_ring(reinterpret_cast<char*>(MAP_FAILED)), sqes(reinterpret_cast<io_uring_sqe*>(MAP_FAILED)), pending(0) {
+        std::vector<iovec> buffers;
+
+        try {
+            for (auto ring : rings) {
+                auto storage = ring->get_storage();
+
+                this->rings.push_back(_ring{ring, false, false});
+                buffers.push_back(iovec{storage.data, storage.length});
+            }
+        } catch (std::bad_alloc&) {
+            throw ring_buffer_out_of_memory_exception{};
+        }
+
+        memset(&params, 0, sizeof(params));
+
+        // Whatever fails after the descriptor exists is cleaned up by release()
+        try {
+            check(-1 != (fd = syscall(__NR_io_uring_setup, entries, &params)));
+
+            sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned int);
+            cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+
+            if (params.features & IORING_FEAT_SINGLE_MMAP)
+                sq_ring_size = cq_ring_size = std::max(sq_ring_size, cq_ring_size);
+
+            check(MAP_FAILED != (sq_ring = reinterpret_cast<char*>(mmap(nullptr, sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING))));
+
+            if (params.features & IORING_FEAT_SINGLE_MMAP)
+                cq_ring = sq_ring;
+            else
+                check(MAP_FAILED != (cq_ring = reinterpret_cast<char*>(mmap(nullptr, cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING))));
+
+            check(MAP_FAILED != (sqes = reinterpret_cast<io_uring_sqe*>(mmap(nullptr, params.sq_entries * sizeof(io_uring_sqe), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES))));
+            check(buffers.empty() or (0 == syscall(__NR_io_uring_register, fd, IORING_REGISTER_BUFFERS, buffers.data(), buffers.size())));
+        } catch (std::system_error&) {
+            release();
+            throw;
+        }
+    }
+
+
+    void release() {
+        if (MAP_FAILED != reinterpret_cast<void*>(sqes))
+            munmap(sqes, params.sq_entries * sizeof(io_uring_sqe));
+
+        if ((MAP_FAILED != cq_ring) and (cq_ring != sq_ring))
+            munmap(cq_ring, cq_ring_size);
+
+        if (MAP_FAILED != sq_ring)
+            munmap(sq_ring, sq_ring_size);
+
+        if (-1 != fd)
+            close(fd);
+    }
+
+
+    ~ring_buffer_uring_implementation() {
+        release();
+    }
+
+
+    void enter(unsigned int wait) throw (std::system_error) {
+        if ((0 < pending) or (0 < wait)) {
+            int result;
+
+            do {
+                result = syscall(__NR_io_uring_enter, fd, pending, wait, (0 < wait) ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            } while ((-1 == result) and (EINTR == errno));
+
+            check(-1 != result);
+            pending -= result;
+        }
+    }
+
+
+    // Queues a fixed-buffer transfer; user_data carries the ring index and direction
+    void submit(int opcode, size_t ring, int fd, const ring_buffer_span& span) throw (std::system_error) {
+        auto tail = sq_tail().load(std::memory_order_relaxed);
+
+        if (tail - sq_head().load(std::memory_order_acquire) == params.sq_entries)
+            enter(0);
+
+        auto index = tail & *reinterpret_cast<unsigned int*>(sq_ring + params.sq_off.ring_mask);
+        auto& sqe = sqes[index];
+
+        memset(&sqe, 0, sizeof(sqe));
+        sqe.opcode = opcode;
+        sqe.fd = fd;
+        sqe.addr = reinterpret_cast<uintptr_t>(span.data);
+        sqe.len = span.length;
+        sqe.buf_index = ring;
+        sqe.user_data = 2 * ring + ((IORING_OP_WRITE_FIXED == opcode) ? 1 : 0);
+        sq_array()[index] = index;
+        sq_tail().store(tail + 1, std::memory_order_release);
+        pending++;
+    }
+
+
+    _ring& ring_at(size_t ring) throw (ring_buffer_invalid_address_exception) {
+        if (ring >= rings.size())
+            throw ring_buffer_invalid_address_exception{};
+
+        return rings[ring];
+    }
+
+
+    // Reads into the first contiguous stretch of free space; a wrapped remainder is
+    // picked up by the next fill
+    bool fill(size_t ring, int fd) throw (std::system_error, ring_buffer_invalid_address_exception) {
+        auto& target = ring_at(ring);
+        auto result = false;
+        size_t read, write;
+
+        target.ring->get_available(read, write);
+
+        if (not target.filling and (0 < write)) {
+            submit(IORING_OP_READ_FIXED, ring, fd, target.ring->reserve(write)[0]);
+            target.filling = result = true;
+        }
+
+        return result;
+    }
+
+
+    bool drain(size_t ring, int fd) throw (std::system_error, ring_buffer_invalid_address_exception) {
+        auto& target = ring_at(ring);
+        auto result = false;
+
+        if (not target.draining) {
+            auto span = target.ring->peek()[0];
+
+            if (0 < span.length) {
+                submit(IORING_OP_WRITE_FIXED, ring, fd, span);
+                target.draining = result = true;
+            }
+        }
+
+        return result;
+    }
+
+
+    // Submits whatever is queued, waits for at least wait completions and retires all
+    // that are ready. Each completion is handed to the callback once its bytes have been
+    // committed or consumed; a failed transfer only releases its reservation or peek, and
+    // one whose reservation or peek was cancelled meanwhile reports -ECANCELED. Each CQE
+    // is released before any callback runs, so a std::system_error thrown from one (the
+    // only exception allowed out) leaves the rest queued for the next call.
+    size_t complete(unsigned int wait, const ring_buffer_uring_callback& callback) throw (std::system_error) {
+        size_t result = 0;
+
+        enter(wait);
+
+        auto head = cq_head().load(std::memory_order_relaxed), tail = cq_tail().load(std::memory_order_acquire);
+        auto mask = *reinterpret_cast<unsigned int*>(cq_ring + params.cq_off.ring_mask);
+
+        for (; head != tail; head++, result++) {
+            auto cqe = cqes()[head & mask];
+            ring_buffer_uring_completion completion{static_cast<size_t>(cqe.user_data / 2), 0 != (cqe.user_data % 2), cqe.res};
+            auto& target = rings[completion.ring];
+            auto length = (0 <= cqe.res) ? static_cast<size_t>(cqe.res) : 0;
+
+            cq_head().store(head + 1, std::memory_order_release);
+
+            try {
+                if (completion.drain) {
+                    target.draining = false;
+                    target.ring->consume(length);
+                }
+                else {
+                    target.filling = false;
+                    target.ring->commit(length);
+                }
+            } catch (ring_buffer_exception&) {
+                completion.result = -ECANCELED;
+            }
+
+            if (callback)
+                callback(completion);
+        }
+
+        return result;
+    }
+};
+
+
+ring_buffer_uring::ring_buffer_uring(const std::vector<ring_buffer*>& rings, unsigned int entries) throw (std::system_error, ring_buffer_out_of_memory_exception) : implementation(new ring_buffer_uring_implementation{rings, entries}) { }
+bool ring_buffer_uring::fill(size_t ring, int fd) throw (std::system_error, ring_buffer_invalid_address_exception) { return implementation->fill(ring, fd); }
+bool ring_buffer_uring::drain(size_t ring, int fd) throw (std::system_error, ring_buffer_invalid_address_exception) { return implementation->drain(ring, fd); }
+size_t ring_buffer_uring::complete(unsigned int wait, const ring_buffer_uring_callback& callback) throw (std::system_error) { return implementation->complete(wait, callback); }
+ring_buffer_uring::~ring_buffer_uring() throw () { }
@@ -0,0 +1,63 @@
+/*
+    Copyright 2011 Emilio Guijarro
+
+    This file is part of the Ring Buffer library.
+
+    The Ring Buffer library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Ring Buffer library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Ring Buffer library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+
+#include <functional>
+#include <vector>
+
+#include "ring_buffer.hpp"
+
+
+struct ring_buffer_uring_completion {
+    size_t ring; // Index of the ring in the vector the driver was built from
+    bool drain; // Whether the transfer was a drain rather than a fill
+    int result; // Bytes transferred, 0 for end of file on a fill, or a negated errno
+};
+
+
+// Feeds rings from descriptors and drains them to descriptors through io_uring, so one
+// thread can service many socket-backed rings without blocking in read or write. Every
+// ring's data area is registered as a fixed buffer. fill() submits a read into the
+// ring's writable space and drain() a write from its readable space; complete() reaps
+// the results, committing or consuming the bytes actually transferred, which fires the
+// ring's callbacks as usual, and hands each result to the caller. While an operation is
+// in flight the driver acts as that ring's producer (fill) or consumer (drain), so nobody
+// else may reserve or peek on it; another write (read) cancels the fill (drain), which
+// then completes with -ECANCELED. The driver keeps pointers to the rings and the kernel
+// keeps their registered data areas, so a ring must not be moved, reassigned or
+// destroyed while the driver exists.
+class ring_buffer_uring {
+private:
+    class ring_buffer_uring_implementation; std::unique_ptr<ring_buffer_uring_implementation> implementation;
+
+
+public:
+    typedef std::function<void (const ring_buffer_uring_completion&)> ring_buffer_uring_callback;
+
+    ring_buffer_uring(const std::vector<ring_buffer*>& rings, unsigned int entries) throw (std::system_error, ring_buffer_out_of_memory_exception);
+    ring_buffer_uring(const ring_buffer_uring& other) = delete;
+    ring_buffer_uring& operator=(const ring_buffer_uring& other) = delete;
+    bool fill(size_t ring, int fd) throw (std::system_error, ring_buffer_invalid_address_exception);
+    bool drain(size_t ring, int fd) throw (std::system_error, ring_buffer_invalid_address_exception);
+    size_t complete(unsigned int wait, const ring_buffer_uring_callback& callback) throw (std::system_error);
+    ~ring_buffer_uring() throw ();
+};
@@ -0,0 +1,177 @@
+/*
+    Copyright 2011 Emilio Guijarro
+
+    This file is part of the Ring Buffer library.
+
+    The Ring Buffer library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Ring Buffer library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Ring Buffer library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "spsc_ring_buffer.hpp"
+#include <atomic>
+#include <cstring>
+
+
+struct spsc_ring_buffer::spsc_ring_buffer_implementation {
+    struct _callback {
+        ring_buffer_callback callback;
+        size_t threshold;
+    };
+
+
+    static const size_t cache_line_size = 64;
+
+
+    // Each side owns a cache line holding its cursor and its last seen copy of the
+    // other side's cursor, so the shared line is only touched when the ring looks
+    // full (writer) or empty (reader)
+    std::unique_ptr<char[]> buffer;
+    size_t capacity, mask;
+    _callback read_callback, write_callback;
+    char _padding0[cache_line_size];
+    std::atomic<size_t> _write;
+    size_t cached_read;
+    char _padding1[cache_line_size - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+    std::atomic<size_t> _read;
+    size_t cached_write;
+    char _padding2[cache_line_size - sizeof(std::atomic<size_t>) - sizeof(size_t)];
+
+
+    inline size_t ring_buffer_offset(size_t position) { return (0 != mask) ? (position & mask) : (position % capacity); }
+
+
+    spsc_ring_buffer_implementation(size_t capacity) throw (ring_buffer_out_of_memory_exception) : capacity(capacity), mask((0 == (capacity & (capacity - 1))) ? capacity - 1 : 0), _write(0), cached_read(0), _read(0), cached_write(0) {
+        try {
+            buffer.reset(new char[capacity]);
+        } catch (std::bad_alloc&) {
+            throw ring_buffer_out_of_memory_exception{};
+        }
+    }
+
+
+    void set_read_callback(ring_buffer_callback callback, size_t threshold) throw () {
+        read_callback.callback = callback;
+        read_callback.threshold = threshold;
+    }
+
+
+    void set_write_callback(ring_buffer_callback callback, size_t threshold) throw () {
+        write_callback.callback = callback;
+        write_callback.threshold = threshold;
+    }
+
+
+    // Only the writer stores _write and only the reader stores _read: each side
+    // publishes its cursor with release and observes the other's with acquire.
+    bool try_write(const void* data, size_t length) throw (ring_buffer_invalid_address_exception) {
+        auto result = false;
+
+        if (nullptr != data) {
+            auto write = _write.load(std::memory_order_relaxed);
+
+            if (capacity - (write - cached_read) < length)
+                cached_read = _read.load(std::memory_order_acquire);
+
+            if (capacity - (write - cached_read) >= length) {
+                auto left = length;
+
+                while (left > 0) {
+                    auto target = ring_buffer_offset(write), size = std::min(left, capacity - target);
+
+                    memcpy(buffer.get() + target, reinterpret_cast<const char*>(data) + length - left, size);
+                    left -= size;
+                    write += size;
+                }
+
+                _write.store(write, std::memory_order_release);
+
+                if (read_callback.callback and (write - _read.load(std::memory_order_acquire) >= read_callback.threshold))
+                    read_callback.callback();
+
+                result = true;
+            }
+        }
+        else
+            throw ring_buffer_invalid_address_exception{};
+
+        return result;
+    }
+
+
+    void write(const void* data, size_t length) throw (ring_buffer_overflow_exception, ring_buffer_invalid_address_exception) {
+        if (not try_write(data, length))
+            throw ring_buffer_overflow_exception{};
+    }
+
+
+    bool try_read(void* data, size_t length) throw (ring_buffer_invalid_address_exception) {
+        auto result = false;
+
+        if (nullptr != data) {
+            auto read = _read.load(std::memory_order_relaxed);
+
+            if (cached_write - read < length)
+                cached_write = _write.load(std::memory_order_acquire);
+
+            if (cached_write - read >= length) {
+                auto left = length;
+
+                while (left > 0) {
+                    auto target = ring_buffer_offset(read), size = std::min(left, capacity - target);
+
+                    memcpy(reinterpret_cast<char*>(data) + length - left, buffer.get() + target, size);
+                    left -= size;
+                    read += size;
+                }
+
+                _read.store(read, std::memory_order_release);
+
+                if (write_callback.callback and (capacity - (_write.load(std::memory_order_acquire) - read) >= write_callback.threshold))
+                    write_callback.callback();
+
+                result = true;
+            }
+        }
+        else
+            throw ring_buffer_invalid_address_exception{};
+
+        return result;
+    }
+
+
+    void read(void* data, size_t length) throw (ring_buffer_underflow_exception, ring_buffer_invalid_address_exception) {
+        if (not try_read(data, length))
+            throw ring_buffer_underflow_exception{};
+    }
+
+
+    void get_available(size_t& read, size_t& write) throw () {
+        // Loading _read first guarantees the snapshot never goes negative
+        auto consumed = _read.load(std::memory_order_acquire);
+
+        read = _write.load(std::memory_order_acquire) - consumed;
+        write = capacity - read;
+    }
+};
+
+
+spsc_ring_buffer::spsc_ring_buffer(size_t capacity) throw (ring_buffer_out_of_memory_exception) : implementation(new spsc_ring_buffer_implementation{capacity}) { }
+void spsc_ring_buffer::set_read_callback(ring_buffer_callback callback, size_t threshold) throw () { implementation->set_read_callback(callback, threshold); }
+void spsc_ring_buffer::set_write_callback(ring_buffer_callback callback, size_t threshold) throw () { implementation->set_write_callback(callback, threshold); }
+void spsc_ring_buffer::write(const void* data, size_t length) throw (ring_buffer_overflow_exception, ring_buffer_invalid_address_exception) { implementation->write(data, length); }
+void spsc_ring_buffer::read(void* data, size_t length) throw (ring_buffer_underflow_exception, ring_buffer_invalid_address_exception) { implementation->read(data, length); }
+bool spsc_ring_buffer::try_write(const void* data, size_t length) throw (ring_buffer_invalid_address_exception) { return implementation->try_write(data, length); }
+bool spsc_ring_buffer::try_read(void* data, size_t length) throw (ring_buffer_invalid_address_exception) { return implementation->try_read(data, length); }
+void spsc_ring_buffer::get_available(size_t& read, size_t& write) throw () { implementation->get_available(read, write); }
+spsc_ring_buffer::~spsc_ring_buffer() throw () { }
@@ -0,0 +1,50 @@
+/*
+    Copyright 2011 Emilio Guijarro
+
+    This file is part of the Ring Buffer library.
+
+    The Ring Buffer library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Ring Buffer library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Ring Buffer library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+
+#include "ring_buffer.hpp"
+
+
+// Lock-free variant of ring_buffer for exactly one writer thread and one reader
+// thread. Callbacks run on the thread that crossed the threshold and must be set
+// before the ring is shared between threads.
+class spsc_ring_buffer {
+private:
+    class spsc_ring_buffer_implementation; std::unique_ptr<spsc_ring_buffer_implementation> implementation;
+
+
+public:
+    typedef ring_buffer::ring_buffer_callback ring_buffer_callback;
+
+
+    spsc_ring_buffer(size_t capacity) throw (ring_buffer_out_of_memory_exception);
+    spsc_ring_buffer(const spsc_ring_buffer& other) = delete;
+    spsc_ring_buffer& operator=(const spsc_ring_buffer& other) = delete;
+    void set_read_callback(ring_buffer_callback callback, size_t threshold) throw ();
+    void set_write_callback(ring_buffer_callback callback, size_t threshold) throw ();
+    void write(const void* data, size_t length) throw (ring_buffer_overflow_exception, ring_buffer_invalid_address_exception);
+    void read(void* data, size_t length) throw (ring_buffer_underflow_exception, ring_buffer_invalid_address_exception);
+    bool try_write(const void* data, size_t length) throw (ring_buffer_invalid_address_exception);
+    bool try_read(void* data, size_t length) throw (ring_buffer_invalid_address_exception);
+    void get_available(size_t& read, size_t& write) throw ();
+    ~spsc_ring_buffer() throw ();
+};
@@ -0,0 +1,157 @@
+/*
+    Copyright 2011 Emilio Guijarro
+
+    This file is part of the Ring Buffer library.
+
+    The Ring Buffer library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Ring Buffer library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Ring Buffer library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+
+#include <algorithm>
+#include <cstring>
+
+#include "ring_buffer.hpp"
+
+
+// Byte ring whose capacity is a compile-time constant and whose storage lives inside
+// the object, so index math constant-folds and every call can be inlined. It is not
+// synchronized: each instance is meant to be owned by a single thread.
+template <size_t N>
+class static_ring_buffer {
+private:
+    static_assert(N > 0, "static_ring_buffer capacity must be positive");
+
+
+    char buffer[N];
+    size_t _read, _write;
+
+
+    inline size_t ring_buffer_readable() const { return _write - _read; }
+    inline size_t ring_buffer_writable() const { return N - ring_buffer_readable(); }
+
+
+    void copy_to(size_t position, const void* data, size_t length) {
+        auto target = position % N, size = std::min(length, N - target);
+
+        memcpy(buffer + target, data, size);
+
+        if (size < length)
+            memcpy(buffer, reinterpret_cast<const char*>(data) + size, length - size);
+    }
+
+
+    void copy_from(size_t position, void* data, size_t length) const {
+        auto target = position % N, size = std::min(length, N - target);
+
+        memcpy(data, buffer + target, size);
+
+        if (size < length)
+            memcpy(reinterpret_cast<char*>(data) + size, buffer, length - size);
+    }
+
+
+public:
+    static constexpr size_t capacity = N;
+
+
+    static_ring_buffer() : _read(0), _write(0) { }
+
+
+    bool try_write(const void* data, size_t length) throw (ring_buffer_invalid_address_exception) {
+        auto result = false;
+
+        if (nullptr != data) {
+            if (ring_buffer_writable() >= length) {
+                copy_to(_write, data, length);
+                _write += length;
+                result = true;
+            }
+        }
+        else
+            throw ring_buffer_invalid_address_exception{};
+
+        return result;
+    }
+
+
+    bool try_read(void* data, size_t length) throw (ring_buffer_invalid_address_exception) {
+        auto result = false;
+
+        if (nullptr != data) {
+            if (ring_buffer_readable() >= length) {
+                copy_from(_read, data, length);
+                _read += length;
+                result = true;
+            }
+        }
+        else
+            throw ring_buffer_invalid_address_exception{};
+
+        return result;
+    }
+
+
+    void write(const void* data, size_t length) throw (ring_buffer_overflow_exception, ring_buffer_invalid_address_exception) {
+        if (not try_write(data, length))
+            throw ring_buffer_overflow_exception{};
+    }
+
+
+    void read(void* data, size_t length) throw (ring_buffer_underflow_exception, ring_buffer_invalid_address_exception) {
+        if (not try_read(data, length))
+            throw ring_buffer_underflow_exception{};
+    }
+
+
+    size_t write_some(const void* data, size_t length) throw (ring_buffer_invalid_address_exception) {
+        size_t result = 0;
+
+        if (nullptr != data) {
+            result = std::min(length, ring_buffer_writable());
+            copy_to(_write, data, result);
+            _write += result;
+        }
+        else
+            throw ring_buffer_invalid_address_exception{};
+
+        return result;
+    }
+
+
+    size_t read_some(void* data, size_t length) throw (ring_buffer_invalid_address_exception) {
+        size_t result = 0;
+
+        if (nullptr != data) {
+            result = std::min(length, ring_buffer_readable());
+            copy_from(_read, data, result);
+            _read += result;
+        }
+        else
+            throw ring_buffer_invalid_address_exception{};
+
+        return result;
+    }
+
+
+    void get_available(size_t& read, size_t& write) const throw () {
+        read = ring_buffer_readable();
+        write = ring_buffer_writable();
+    }
+};
+
+
+template <size_t N> constexpr size_t static_ring_buffer<N>::capacity;
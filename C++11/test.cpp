@@ -18,10 +18,29 @@
 */
 
 
+#include <algorithm>
 #include <cassert>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <fcntl.h>
+#include <unistd.h>
 
+#include "broadcast_ring_buffer.hpp"
+#include "mpmc_ring_buffer.hpp"
+#include "mpsc_ring_buffer.hpp"
 #include "ring_buffer.hpp"
+#include "ring_buffer_uring.hpp"
+#include "spsc_ring_buffer.hpp"
+#include "static_ring_buffer.hpp"
+#include "typed_ring_buffer.hpp"
 
 
 static void simple() {
@@ -108,6 +127,42 @@ static void async() {
 }
 
 
+static bool signalled(int fd) {
+    uint64_t value;
+
+    return sizeof(value) == ::read(fd, &value, sizeof(value));
+}
+
+
+static void events() {
+    try {
+        ring_buffer buffer{16};
+        unsigned char temp_buffer[16] = { 0 };
+        auto read_fd = buffer.set_read_eventfd(8), write_fd = buffer.set_write_eventfd(12);
+
+        assert(not signalled(read_fd) and signalled(write_fd));
+
+        // Crossing the threshold signals once, staying above it does not signal again
+        buffer.write(temp_buffer, 4);
+        assert(not signalled(read_fd));
+        buffer.write(temp_buffer, 4);
+        assert(signalled(read_fd));
+        buffer.write(temp_buffer, 4);
+        assert(not signalled(read_fd) and not signalled(write_fd));
+
+        // Dropping below the threshold rearms the event
+        buffer.read(temp_buffer, 8);
+        assert(not signalled(read_fd) and signalled(write_fd));
+        buffer.write(temp_buffer, 4);
+        assert(signalled(read_fd));
+
+        assert(read_fd == buffer.set_read_eventfd(4));
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
 static unsigned char write_counter = 0;
 static unsigned char read_counter = 0;
 
@@ -134,6 +189,52 @@ static void verify(void* buffer, size_t length) {
 }
 
 
+// Copies carry only the live region, moves and swaps just hand over the storage
+static void moved(const size_t ring_buffer_size, const size_t ring_count) {
+    static_assert(std::is_nothrow_move_constructible<ring_buffer>::value and std::is_nothrow_move_assignable<ring_buffer>::value, "ring_buffer moves must not throw");
+
+    try {
+        std::vector<ring_buffer> buffers;
+        std::vector<char> temp_buffer(ring_buffer_size);
+
+        // Leave a live region that wraps around the end of the storage
+        ring_buffer buffer{ring_buffer_size};
+
+        sync(0);
+        produce(temp_buffer.data(), ring_buffer_size * 3 / 4);
+        buffer.write(temp_buffer.data(), ring_buffer_size * 3 / 4);
+        buffer.read(temp_buffer.data(), ring_buffer_size / 2);
+        verify(temp_buffer.data(), ring_buffer_size / 2);
+        produce(temp_buffer.data(), ring_buffer_size / 2);
+        buffer.write(temp_buffer.data(), ring_buffer_size / 2);
+
+        ring_buffer copy{buffer};
+        auto storage = buffer.get_storage().data;
+
+        for (size_t i = 0; i < ring_count; i++)
+            buffers.emplace_back(ring_buffer_size);
+
+        buffers.push_back(std::move(buffer));
+        assert(storage == buffers.back().get_storage().data);
+
+        swap(buffers.front(), buffers.back());
+        assert(storage == buffers.front().get_storage().data);
+
+        buffer = std::move(buffers.front());
+        assert(storage == buffer.get_storage().data);
+
+        // Both hold the same bytes, so the reads replay the same counter sequence
+        for (auto ring : { &buffer, &copy }) {
+            sync(ring_buffer_size / 2);
+            ring->read(temp_buffer.data(), ring_buffer_size * 3 / 4);
+            verify(temp_buffer.data(), ring_buffer_size * 3 / 4);
+        }
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
 static void sequential(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
     try {
         ring_buffer buffer{ring_buffer_size};
@@ -225,6 +326,384 @@ static void interleaved(const size_t byte_count, const size_t ring_buffer_size,
 }
 
 
+static void partial(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    try {
+        ring_buffer buffer{ring_buffer_size};
+        void* temp_buffer = malloc(max_block_size);
+        size_t count = 0;
+
+        assert(0 == buffer.read_some(temp_buffer, max_block_size));
+        sync(0);
+
+        while (count < byte_count) {
+            size_t length = rand() % max_block_size, transferred;
+
+            produce(temp_buffer, length);
+            transferred = buffer.write_some(temp_buffer, length);
+            assert(transferred <= length);
+            revert(length - transferred);
+
+            length = rand() % max_block_size;
+            transferred = buffer.read_some(temp_buffer, length);
+            assert(transferred <= length);
+            verify(temp_buffer, transferred);
+            count += transferred;
+        }
+
+        free(temp_buffer);
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
+// Blocks are split into three segments at random points on both sides
+static void split(iovec (&vector)[3], void* data, size_t length) {
+    size_t first = rand() % (length + 1), second = first + rand() % (length - first + 1);
+
+    vector[0].iov_base = data;
+    vector[0].iov_len = first;
+    vector[1].iov_base = static_cast<char*>(data) + first;
+    vector[1].iov_len = second - first;
+    vector[2].iov_base = static_cast<char*>(data) + second;
+    vector[2].iov_len = length - second;
+}
+
+
+static void vectored(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    try {
+        ring_buffer buffer{ring_buffer_size};
+        iovec vector[3];
+        void* temp_buffer = malloc(max_block_size);
+        size_t count = 0;
+
+        try { buffer.writev(nullptr, 1); assert(false); } catch (ring_buffer_invalid_address_exception) { }
+        sync(0);
+
+        while (count < byte_count) {
+            size_t length = rand() % max_block_size;
+
+            produce(temp_buffer, length);
+            split(vector, temp_buffer, length);
+
+            try {
+                buffer.writev(vector, 3);
+            } catch (ring_buffer_overflow_exception) {
+                revert(length);
+            }
+
+            length = rand() % max_block_size;
+            split(vector, temp_buffer, length);
+
+            try {
+                buffer.readv(vector, 3);
+            } catch (ring_buffer_underflow_exception) {
+                continue;
+            }
+
+            verify(temp_buffer, length);
+            count += length;
+        }
+
+        free(temp_buffer);
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
+// Bytes go producer -> pipe -> ring -> pipe -> consumer, entering and leaving the ring
+// only through the descriptor operations
+static void descriptors(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    try {
+        ring_buffer buffer{ring_buffer_size};
+        std::vector<char> temp_buffer(ring_buffer_size + max_block_size);
+        size_t count = 0;
+        int input[2], output[2];
+
+        assert((0 == pipe(input)) and (0 == pipe(output)));
+        assert(-1 != fcntl(input[0], F_SETFL, O_NONBLOCK));
+        try { buffer.fill_from_fd(input[0], max_block_size); assert(false); } catch (std::system_error& error) { assert(EAGAIN == error.code().value()); }
+        sync(0);
+
+        while (count < byte_count) {
+            size_t length = rand() % max_block_size, transferred;
+
+            // Filling takes up to twice the average block so the input pipe keeps draining
+            produce(temp_buffer.data(), length);
+            assert(length == static_cast<size_t>(::write(input[1], temp_buffer.data(), length)));
+
+            try {
+                buffer.fill_from_fd(input[0], rand() % (2 * max_block_size));
+            } catch (std::system_error& error) {
+                assert(EAGAIN == error.code().value());
+            }
+
+            transferred = buffer.drain_to_fd(output[1], rand() % ring_buffer_size);
+            assert(transferred == static_cast<size_t>(::read(output[0], temp_buffer.data(), transferred)));
+            verify(temp_buffer.data(), transferred);
+            count += transferred;
+        }
+
+        // Once the writer is gone the drained pipe reads as end of file rather than EAGAIN
+        close(input[1]);
+
+        do {
+            size_t read, write;
+
+            buffer.get_available(read, write);
+            buffer.skip(read);
+        } while (0 < buffer.fill_from_fd(input[0], ring_buffer_size));
+
+        for (auto fd : { input[0], output[0], output[1] })
+            close(fd);
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
+// Same path as descriptors(), with io_uring moving the bytes in and out of the ring
+static void uring(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    try {
+        ring_buffer buffer{ring_buffer_size};
+        std::unique_ptr<ring_buffer_uring> driver;
+        std::vector<char> temp_buffer(64*1024);
+        size_t count = 0, callbacks = 0, readable, writable;
+        int input[2], output[2];
+
+        // Kernels without io_uring, or with it restricted to privileged users, leave
+        // nothing to test
+        try {
+            driver.reset(new ring_buffer_uring{{ &buffer }, 8});
+        } catch (std::system_error& error) {
+            assert((ENOSYS == error.code().value()) or (EPERM == error.code().value()));
+            return;
+        }
+
+        assert((0 == pipe(input)) and (0 == pipe(output)));
+        assert(-1 != fcntl(output[0], F_SETFL, O_NONBLOCK));
+        buffer.set_read_callback([&]() { callbacks++; }, 1);
+        try { driver->fill(1, input[0]); assert(false); } catch (ring_buffer_invalid_address_exception) { }
+        sync(0);
+
+        while (count < byte_count) {
+            size_t length = 1 + rand() % max_block_size;
+
+            produce(temp_buffer.data(), length);
+            assert(length == static_cast<size_t>(::write(input[1], temp_buffer.data(), length)));
+
+            driver->fill(0, input[0]);
+            driver->drain(0, output[1]);
+            driver->complete(1, [&](const ring_buffer_uring_completion& completion) { assert((0 == completion.ring) and (0 < completion.result)); });
+
+            auto transferred = ::read(output[0], temp_buffer.data(), temp_buffer.size());
+
+            if (0 < transferred) {
+                verify(temp_buffer.data(), transferred);
+                count += transferred;
+            }
+        }
+
+        assert(0 < callbacks);
+
+        // Once the writer is gone a fill completes with nothing, which must not look
+        // like a failure
+        close(input[1]);
+
+        for (auto eof = false; not eof; ) {
+            driver->fill(0, input[0]);
+            driver->drain(0, output[1]);
+            driver->complete(1, [&](const ring_buffer_uring_completion& completion) { assert(0 <= completion.result); eof = eof or ((not completion.drain) and (0 == completion.result)); });
+
+            while (0 < ::read(output[0], temp_buffer.data(), temp_buffer.size()))
+                ;
+        }
+
+        // A write landing while a fill is in flight cancels the fill, which has to be
+        // reported rather than thrown out of complete()
+        auto cancelled = false;
+
+        buffer.get_available(readable, writable);
+        buffer.skip(readable);
+        close(input[0]);
+        assert(0 == pipe(input));
+        assert(1 == ::write(input[1], temp_buffer.data(), 1));
+        assert(driver->fill(0, input[0]));
+        buffer.write(temp_buffer.data(), 1);
+        // A drain left in flight above has had its peek cancelled by the skip as well
+        for (auto filled = false; not filled; ) {
+            driver->complete(1, [&](const ring_buffer_uring_completion& completion) {
+                if (not completion.drain) {
+                    filled = true;
+                    cancelled = (-ECANCELED == completion.result);
+                }
+            });
+        }
+
+        assert(cancelled);
+
+        for (auto fd : { input[0], input[1], output[0], output[1] })
+            close(fd);
+    } catch (std::system_error&) {
+        assert(false);
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
+static void reserve_commit(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    try {
+        ring_buffer buffer{ring_buffer_size};
+        void* temp_buffer = malloc(max_block_size);
+        size_t count = 0, read, write;
+
+        try { buffer.reserve(ring_buffer_size + 1); assert(false); } catch (ring_buffer_overflow_exception) { }
+        try { buffer.commit(1); assert(false); } catch (ring_buffer_overflow_exception) { }
+        sync(0);
+
+        while (count < byte_count) {
+            size_t length = rand() % max_block_size;
+
+            try {
+                auto spans = buffer.reserve(length);
+
+                assert(spans[0].length + spans[1].length == length);
+                produce(spans[0].data, spans[0].length);
+                produce(spans[1].data, spans[1].length);
+                buffer.commit(length);
+            } catch (ring_buffer_overflow_exception) { }
+
+            length = rand() % max_block_size;
+
+            try {
+                buffer.read(temp_buffer, length);
+            } catch (ring_buffer_underflow_exception) {
+                continue;
+            }
+
+            verify(temp_buffer, length);
+            count += length;
+        }
+
+        // A partial commit only publishes the leading bytes of the reservation
+        buffer.get_available(read, write);
+        buffer.reserve(write);
+        buffer.commit(1);
+        buffer.get_available(count, write);
+        assert(count == read + 1);
+        try { buffer.commit(1); assert(false); } catch (ring_buffer_overflow_exception) { }
+
+        // A write in between cancels the reservation instead of publishing bytes nobody wrote
+        buffer.get_available(read, write);
+        buffer.skip(read);
+        buffer.reserve(ring_buffer_size);
+        buffer.write(temp_buffer, 1);
+        try { buffer.commit(ring_buffer_size); assert(false); } catch (ring_buffer_overflow_exception) { }
+        buffer.get_available(read, write);
+        assert(read == 1);
+
+        free(temp_buffer);
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
+static void peek_consume(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    try {
+        ring_buffer buffer{ring_buffer_size};
+        void* temp_buffer = malloc(max_block_size);
+        size_t count = 0, read, write;
+
+        auto spans = buffer.peek();
+
+        assert((spans[0].length == 0) && (spans[1].length == 0));
+        try { buffer.consume(1); assert(false); } catch (ring_buffer_underflow_exception) { }
+        try { buffer.skip(1); assert(false); } catch (ring_buffer_underflow_exception) { }
+        sync(0);
+
+        while (count < byte_count) {
+            size_t length = rand() % max_block_size;
+
+            produce(temp_buffer, length);
+
+            try {
+                buffer.write(temp_buffer, length);
+            } catch (ring_buffer_overflow_exception) {
+                revert(length);
+            }
+
+            spans = buffer.peek();
+            length = std::min<size_t>(rand() % max_block_size, spans[0].length + spans[1].length);
+
+            // Alternate between verifying in place and discarding without a copy
+            if (rand() % 2) {
+                auto head = std::min(length, spans[0].length);
+
+                verify(spans[0].data, head);
+                verify(spans[1].data, length - head);
+                buffer.consume(length);
+            }
+            else {
+                read_counter += length;
+                buffer.skip(length);
+            }
+
+            count += length;
+        }
+
+        // A read in between cancels the peek instead of releasing bytes twice
+        buffer.get_available(read, write);
+        buffer.skip(read);
+        buffer.write(temp_buffer, 2);
+        buffer.peek();
+        buffer.skip(1);
+        try { buffer.consume(2); assert(false); } catch (ring_buffer_underflow_exception) { }
+        buffer.get_available(read, write);
+        assert(read == 1);
+
+        free(temp_buffer);
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
+static void nonthrowing(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    try {
+        ring_buffer buffer{ring_buffer_size};
+        void* temp_buffer = malloc(max_block_size);
+        size_t count = 0;
+
+        assert(not buffer.try_read(temp_buffer, 1));
+        assert(not buffer.try_write(temp_buffer, ring_buffer_size + 1));
+        sync(0);
+
+        while (count < byte_count) {
+            size_t length = rand() % max_block_size;
+
+            produce(temp_buffer, length);
+
+            if (not buffer.try_write(temp_buffer, length))
+                revert(length);
+
+            length = rand() % max_block_size;
+
+            if (buffer.try_read(temp_buffer, length)) {
+                verify(temp_buffer, length);
+                count += length;
+            }
+        }
+
+        free(temp_buffer);
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
 static void huge() {
     try {
         const size_t buffer_size = 1024*1024;
@@ -244,10 +723,608 @@ static void huge() {
 }
 
 
-int main() {
-    simple();
+static void attributed(const ring_buffer_attributes& attributes, const size_t byte_count, const size_t max_block_size) {
+    try {
+        ring_buffer buffer{1000, attributes};
+        void* temp_buffer = malloc(max_block_size);
+        size_t count = 0, read, write;
 
-    async();
+        buffer.get_available(read, write);
+        assert((read == 0) && (write >= 1000));
+        assert(!attributes.power_of_two || (0 == (write & (write - 1))));
+        sync(0);
+
+        while (count < byte_count) {
+            size_t length = rand() % max_block_size;
+
+            produce(temp_buffer, length);
+
+            try {
+                buffer.write(temp_buffer, length);
+            } catch (ring_buffer_overflow_exception) {
+                revert(length);
+            }
+
+            length = rand() % max_block_size;
+
+            try {
+                buffer.read(temp_buffer, length);
+            } catch (ring_buffer_underflow_exception) {
+                continue;
+            }
+
+            verify(temp_buffer, length);
+            count += length;
+        }
+
+        ring_buffer other(buffer);
+        size_t other_read, other_write;
+
+        buffer.get_available(read, write);
+        other.get_available(other_read, other_write);
+        assert((read == other_read) && (write == other_write));
+
+        free(temp_buffer);
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+
+    // No power of two at or above this capacity fits in a size_t
+    if (attributes.power_of_two) {
+        try {
+            ring_buffer buffer{SIZE_MAX, attributes};
+            assert(false);
+        } catch (ring_buffer_out_of_memory_exception) {
+        }
+    }
+}
+
+
+// Bump allocator over a single block that counts what is still handed out
+class arena_resource : public ring_buffer_memory_resource {
+private:
+    std::vector<char> block;
+    size_t used;
+
+
+public:
+    size_t live;
+
+
+    arena_resource(size_t size) : block(size), used(0), live(0) { }
+
+
+    void* allocate(size_t bytes, size_t alignment) {
+        auto offset = (reinterpret_cast<uintptr_t>(block.data()) + used + alignment - 1) / alignment * alignment - reinterpret_cast<uintptr_t>(block.data());
+
+        if (offset + bytes > block.size())
+            throw std::bad_alloc{};
+
+        used = offset + bytes;
+        live++;
+
+        return block.data() + offset;
+    }
+
+
+    void deallocate(void* data, size_t bytes, size_t alignment) {
+        live--;
+    }
+
+
+    bool owns(const void* data) const {
+        return (data >= block.data()) and (data < block.data() + used);
+    }
+};
+
+
+// Rings, their copies and their storage are carved out of one block and handed back to it
+static void allocated(const size_t ring_count, const size_t ring_buffer_size) {
+    arena_resource arena{ring_count * (ring_buffer_size + 2048)};
+    ring_buffer_attributes attributes;
+    std::vector<char> temp_buffer(ring_buffer_size);
+
+    attributes.resource = &arena;
+
+    {
+        std::vector<std::unique_ptr<ring_buffer>> buffers;
+
+        sync(0);
+
+        for (size_t i = 0; i < ring_count; i++) {
+            buffers.emplace_back(new ring_buffer{ring_buffer_size, attributes});
+            assert(arena.owns(buffers.back()->get_storage().data));
+            produce(temp_buffer.data(), ring_buffer_size);
+            buffers.back()->write(temp_buffer.data(), ring_buffer_size);
+        }
+
+        assert(arena.live == 2 * ring_count);
+
+        ring_buffer copy{*buffers.front()};
+
+        assert((arena.live == 2 * ring_count + 2) and arena.owns(copy.get_storage().data));
+
+        for (auto& buffer : buffers) {
+            buffer->read(temp_buffer.data(), ring_buffer_size);
+            verify(temp_buffer.data(), ring_buffer_size);
+        }
+    }
+
+    assert(0 == arena.live);
+
+    try {
+        ring_buffer buffer{ring_count * ring_buffer_size * 2, attributes};
+        assert(false);
+    } catch (ring_buffer_out_of_memory_exception&) {
+        assert(0 == arena.live);
+    }
+}
+
+
+// NUMA binding goes through mbind, which rejects nodes that do not exist
+static void placed() {
+    ring_buffer_attributes attributes;
+
+    attributes.prefault = true;
+
+    for (auto node : { 0, ring_buffer_attributes::numa_local })
+        try {
+            attributes.numa_node = node;
+            ring_buffer buffer{1000, attributes};
+        } catch (...) {
+            assert(false);
+        }
+
+    try {
+        attributes.numa_node = 1000000;
+        ring_buffer buffer{1000, attributes};
+        assert(false);
+    } catch (std::system_error& exception) {
+        assert(EINVAL == exception.code().value());
+    }
+}
+
+
+static void blocking(const ring_buffer_wait_strategy strategy, const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    try {
+        ring_buffer buffer{ring_buffer_size};
+        void* temp_buffer = malloc(max_block_size);
+        const auto timeout = std::chrono::seconds(10);
+
+        // Nothing to read and nobody writing: the wait has to give up on time
+        auto start = std::chrono::steady_clock::now();
+        assert(not buffer.read_wait(temp_buffer, 1, std::chrono::milliseconds(10), strategy));
+        assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(10));
+
+        sync(0);
+
+        std::thread producer([&]() {
+            void* temp_buffer = malloc(max_block_size);
+            size_t count = 0;
+
+            while (count < byte_count) {
+                size_t length = std::min<size_t>(rand() % max_block_size, byte_count - count);
+
+                produce(temp_buffer, length);
+                assert(buffer.write_wait(temp_buffer, length, timeout, strategy));
+                count += length;
+            }
+
+            free(temp_buffer);
+        });
+
+        size_t count = 0;
+
+        while (count < byte_count) {
+            size_t length = std::min<size_t>(rand() % max_block_size, byte_count - count);
+
+            // The longest timeout there is has to mean "forever", not overflow into the past
+            assert(buffer.read_wait(temp_buffer, length, std::chrono::nanoseconds::max(), strategy));
+            verify(temp_buffer, length);
+            count += length;
+        }
+
+        producer.join();
+
+        // A callback runs with the mutex held, so a wait from it could never be satisfied
+        auto refused = false;
+
+        buffer.set_read_callback([&]() {
+            try {
+                buffer.read_wait(temp_buffer, 1, timeout, strategy);
+            } catch (std::system_error& error) {
+                refused = (error.code() == std::errc::resource_deadlock_would_occur);
+            }
+        }, 1);
+        buffer.write(temp_buffer, 1);
+        assert(refused);
+
+        free(temp_buffer);
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
+static void spsc(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    try {
+        spsc_ring_buffer buffer{ring_buffer_size};
+
+        sync(0);
+
+        std::thread producer([&]() {
+            void* temp_buffer = malloc(max_block_size);
+            size_t count = 0;
+
+            while (count < byte_count) {
+                size_t length = std::min<size_t>(rand() % max_block_size, byte_count - count);
+
+                produce(temp_buffer, length);
+
+                if (buffer.try_write(temp_buffer, length))
+                    count += length;
+                else {
+                    revert(length);
+                    std::this_thread::yield();
+                }
+            }
+
+            free(temp_buffer);
+        });
+
+        void* temp_buffer = malloc(max_block_size);
+        size_t count = 0;
+
+        while (count < byte_count) {
+            size_t length = std::min<size_t>(rand() % max_block_size, byte_count - count);
+
+            if (buffer.try_read(temp_buffer, length)) {
+                verify(temp_buffer, length);
+                count += length;
+            }
+            else
+                std::this_thread::yield();
+        }
+
+        producer.join();
+        free(temp_buffer);
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
+template <size_t N>
+static void inline_storage(const size_t byte_count, const size_t max_block_size) {
+    try {
+        static_ring_buffer<N> buffer;
+        void* temp_buffer = malloc(max_block_size);
+        size_t count = 0, read, write;
+
+        static_assert(sizeof(buffer) < N + 64, "storage must be inline");
+        buffer.get_available(read, write);
+        assert((read == 0) && (write == N));
+        assert(not buffer.try_read(temp_buffer, 1));
+        try { buffer.write(temp_buffer, N + 1); assert(false); } catch (ring_buffer_overflow_exception) { }
+        sync(0);
+
+        while (count < byte_count) {
+            size_t length = rand() % max_block_size;
+
+            produce(temp_buffer, length);
+
+            if (rand() % 2)
+                revert(length - buffer.write_some(temp_buffer, length));
+            else if (not buffer.try_write(temp_buffer, length))
+                revert(length);
+
+            length = rand() % max_block_size;
+
+            if (rand() % 2)
+                length = buffer.read_some(temp_buffer, length);
+            else if (not buffer.try_read(temp_buffer, length))
+                continue;
+
+            verify(temp_buffer, length);
+            count += length;
+        }
+
+        free(temp_buffer);
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
+static void typed(const size_t item_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    try {
+        typed_ring_buffer<std::string> strings{3};
+        auto shared = std::make_shared<int>(0);
+        std::string item{"moved"};
+        size_t read, write;
+
+        strings.push(std::move(item));
+        assert(item.empty());
+        strings.emplace(4, 'x');
+        strings.push("copied");
+        try { strings.push("overflow"); assert(false); } catch (ring_buffer_overflow_exception) { }
+        strings.get_available(read, write);
+        assert((read == 3) && (write == 0));
+
+        strings.pop(item);
+        assert(item == "moved");
+        strings.pop(item);
+        assert(item == "xxxx");
+        assert(strings.try_push("wrapped"));
+        assert(strings.try_pop(item) && (item == "copied"));
+        assert(strings.try_pop(item) && (item == "wrapped"));
+        assert(not strings.try_pop(item));
+        try { strings.pop(item); assert(false); } catch (ring_buffer_underflow_exception) { }
+
+        // Elements still queued are destroyed along with the ring
+        {
+            typed_ring_buffer<std::shared_ptr<int>> pointers{4};
+
+            pointers.push(shared);
+            pointers.push(shared);
+            assert(shared.use_count() == 3);
+        }
+
+        assert(shared.use_count() == 1);
+
+        // Bulk pushes move elements in when given a move iterator
+        {
+            typed_ring_buffer<std::shared_ptr<int>> pointers{4};
+            std::shared_ptr<int> batch[3] = { shared, shared, shared };
+
+            auto copied = pointers.push_some(batch, 3);
+
+            assert((3 == copied) and (shared.use_count() == 7));
+
+            auto moved = pointers.push_some(std::make_move_iterator(batch), 3);
+
+            assert((1 == moved) and (shared.use_count() == 7) and (nullptr == batch[0]) and (nullptr != batch[1]));
+        }
+
+        assert(shared.use_count() == 1);
+
+        typed_ring_buffer<unsigned int> numbers{ring_buffer_size};
+        std::unique_ptr<unsigned int[]> block{new unsigned int[max_block_size]};
+        unsigned int produced = 0, consumed = 0;
+
+        while (consumed < item_count) {
+            size_t length = rand() % max_block_size;
+
+            for (size_t i = 0; i < length; i++)
+                block[i] = produced + i;
+
+            produced += numbers.push_some(block.get(), length);
+            length = numbers.pop_some(block.get(), rand() % max_block_size);
+
+            for (size_t i = 0; i < length; i++)
+                assert(block[i] == consumed++);
+        }
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
+static void mpmc(const size_t record_count, const size_t ring_buffer_size, const size_t thread_count) {
+    struct record {
+        size_t producer, sequence;
+    };
+
+    try {
+        mpmc_ring_buffer buffer{sizeof(record), ring_buffer_size};
+        std::atomic<size_t> consumed{0}, checksum{0};
+        std::vector<std::thread> threads;
+        record item;
+        size_t read, write;
+
+        buffer.get_available(read, write);
+        assert((read == 0) && (write >= ring_buffer_size));
+        assert(not buffer.try_read(&item));
+        try { buffer.read(&item); assert(false); } catch (ring_buffer_underflow_exception) { }
+
+        // Neither the capacity nor the storage it takes may wrap around a size_t
+        try { mpmc_ring_buffer{sizeof(record), SIZE_MAX}; assert(false); } catch (ring_buffer_out_of_memory_exception) { }
+        try { mpmc_ring_buffer{sizeof(record), SIZE_MAX / 2}; assert(false); } catch (ring_buffer_out_of_memory_exception) { }
+        try { mpmc_ring_buffer{SIZE_MAX, 1}; assert(false); } catch (ring_buffer_out_of_memory_exception) { }
+
+        for (size_t i = 0; i < thread_count; i++) {
+            threads.emplace_back([&, i]() {
+                for (record item = { i, 0 }; item.sequence < record_count; item.sequence++)
+                    while (not buffer.try_write(&item))
+                        std::this_thread::yield();
+            });
+
+            // Records from one producer must reach any given consumer in order
+            threads.emplace_back([&]() {
+                std::vector<size_t> next(thread_count, 0);
+                record item;
+
+                while (consumed.load() < thread_count * record_count) {
+                    if (buffer.try_read(&item)) {
+                        assert(item.sequence >= next[item.producer]);
+                        next[item.producer] = item.sequence + 1;
+                        checksum += item.sequence;
+                        consumed++;
+                    }
+                    else
+                        std::this_thread::yield();
+                }
+            });
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        assert(checksum.load() == thread_count * record_count * (record_count - 1) / 2);
+        buffer.get_available(read, write);
+        assert(read == 0);
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
+static void mpsc(const size_t record_count, const size_t ring_buffer_size, const size_t thread_count) {
+    struct record {
+        size_t producer, sequence;
+        unsigned char payload[64];
+    };
+
+    try {
+        mpsc_ring_buffer buffer{ring_buffer_size};
+        std::vector<size_t> next(thread_count, 0);
+        std::vector<std::thread> threads;
+        size_t consumed = 0, read, write;
+
+        buffer.get_available(read, write);
+        assert((read == 0) && (write >= ring_buffer_size));
+        assert(0 == buffer.drain([](const void*, size_t) { assert(false); }));
+        try { mpsc_ring_buffer{SIZE_MAX}; assert(false); } catch (ring_buffer_out_of_memory_exception) { }
+
+        for (size_t i = 0; i < thread_count; i++)
+            threads.emplace_back([&, i]() {
+                record item;
+
+                for (item.producer = i, item.sequence = 0; item.sequence < record_count; item.sequence++) {
+                    size_t length = 2 * sizeof(size_t) + item.sequence % sizeof(item.payload);
+
+                    memset(item.payload, static_cast<int>(item.sequence), sizeof(item.payload));
+
+                    while (not buffer.try_write(&item, length))
+                        std::this_thread::yield();
+                }
+            });
+
+        // Records from one producer must be drained in order, each with its own length
+        while (consumed < thread_count * record_count) {
+            auto count = buffer.drain([&](const void* data, size_t length) {
+                record item;
+
+                memcpy(&item, data, length);
+                assert(item.sequence == next[item.producer]);
+                assert(length == 2 * sizeof(size_t) + item.sequence % sizeof(item.payload));
+
+                for (size_t j = 0; j < length - 2 * sizeof(size_t); j++)
+                    assert(item.payload[j] == static_cast<unsigned char>(item.sequence));
+
+                next[item.producer]++;
+            });
+
+            if (0 == count)
+                std::this_thread::yield();
+
+            consumed += count;
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        buffer.get_available(read, write);
+        assert(read == 0);
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
+static void broadcast(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size, const size_t reader_count) {
+    try {
+        broadcast_ring_buffer buffer{ring_buffer_size, false};
+        std::vector<broadcast_ring_buffer::ring_buffer_reader> readers;
+        std::vector<std::thread> threads;
+
+        for (size_t i = 0; i < reader_count; i++)
+            readers.push_back(buffer.add_reader());
+
+        // Every reader must see the whole stream: byte n of the stream holds n % 251
+        for (size_t i = 0; i < reader_count; i++)
+            threads.emplace_back([&, i]() {
+                std::vector<unsigned char> temp_buffer(max_block_size);
+                size_t count = 0;
+
+                while (count < byte_count) {
+                    size_t length = std::min<size_t>(1 + rand() % max_block_size, byte_count - count);
+
+                    if (buffer.try_read(readers[i], temp_buffer.data(), length)) {
+                        for (size_t j = 0; j < length; j++)
+                            assert(temp_buffer[j] == (count + j) % 251);
+
+                        count += length;
+                    }
+                    else
+                        std::this_thread::yield();
+                }
+            });
+
+        std::vector<unsigned char> temp_buffer(max_block_size);
+        size_t count = 0;
+
+        while (count < byte_count) {
+            size_t length = std::min<size_t>(1 + rand() % max_block_size, byte_count - count);
+
+            for (size_t j = 0; j < length; j++)
+                temp_buffer[j] = (count + j) % 251;
+
+            if (buffer.try_write(temp_buffer.data(), length))
+                count += length;
+            else
+                std::this_thread::yield();
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+
+        for (auto reader : readers)
+            buffer.remove_reader(reader);
+
+        try { buffer.remove_reader(readers[0]); assert(false); } catch (ring_buffer_invalid_reader_exception) { }
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
+static void lapping() {
+    try {
+        broadcast_ring_buffer buffer{16, true};
+        auto fast = buffer.add_reader(), slow = buffer.add_reader();
+        unsigned char data[16], temp_buffer[16];
+        size_t read, write;
+
+        for (size_t i = 0; i < sizeof(data); i++)
+            data[i] = i;
+
+        buffer.write(data, 12);
+        buffer.read(fast, temp_buffer, 12);
+        buffer.write(data, 12);
+        buffer.read(fast, temp_buffer, 12);
+        assert(0 == memcmp(temp_buffer, data, 12));
+
+        // The slow reader lost the first 8 bytes and resumes at the oldest byte left
+        try { buffer.read(slow, temp_buffer, 1); assert(false); } catch (ring_buffer_lapped_exception) { }
+        buffer.get_available(slow, read, write);
+        assert((read == 16) && (write == 16));
+        buffer.read(slow, temp_buffer, 16);
+        assert((0 == memcmp(temp_buffer, data + 8, 4)) && (0 == memcmp(temp_buffer + 4, data, 12)));
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
+int main() {
+    simple();
+
+    moved(1000, 100);
+
+    async();
+
+    events();
 
     sequential(1024*1024*16, 1024, 16);
     sequential(1024*1024*16, 1024, 512);
@@ -257,7 +1334,69 @@ int main() {
     interleaved(1024*1024*16, 1024, 512);
     interleaved(1024*1024*16, 1024, 1024);
     
+    nonthrowing(1024*1024*16, 1024, 16);
+    nonthrowing(1024*1024*16, 1024, 1024);
+
+    partial(1024*1024*16, 1000, 16);
+    partial(1024*1024*16, 1000, 2048);
+
+    vectored(1024*1024*16, 1000, 16);
+    vectored(1024*1024*16, 1000, 512);
+
+    descriptors(1024*1024, 1000, 16);
+    descriptors(1024*1024*16, 1000, 512);
+
+    uring(1024*1024, 1000, 16);
+    uring(1024*1024*16, 1000, 512);
+
+    reserve_commit(1024*1024*16, 1000, 16);
+    reserve_commit(1024*1024*16, 1000, 512);
+
+    peek_consume(1024*1024*16, 1000, 16);
+    peek_consume(1024*1024*16, 1000, 512);
+
     huge();
 
+    ring_buffer_attributes mirrored, power_of_two, huge, huge_mirrored;
+
+    mirrored.mirrored = true;
+    power_of_two.power_of_two = true;
+    huge.huge_pages = huge.prefault = true;
+    huge_mirrored.mirrored = huge_mirrored.huge_pages = huge_mirrored.locked = true;
+
+    attributed(mirrored, 1024*1024*16, 1024);
+    attributed(mirrored, 1024*1024*16, 8192);
+    attributed(power_of_two, 1024*1024*16, 16);
+    attributed(power_of_two, 1024*1024*16, 1024);
+    attributed(huge, 1024*1024*16, 1024);
+    attributed(huge_mirrored, 1024*1024*16, 1024);
+
+    placed();
+    allocated(1000, 1000);
+
+    inline_storage<1000>(1024*1024*16, 16);
+    inline_storage<1024>(1024*1024*16, 512);
+
+    typed(1024*1024, 1000, 16);
+    typed(1024*1024, 1000, 512);
+
+    mpmc(1024*256, 16, 4);
+    mpmc(1024*256, 1000, 2);
+
+    mpsc(1024*256, 256, 4);
+    mpsc(1024*256, 4096, 2);
+
+    broadcast(1024*1024*4, 1024, 512, 4);
+    lapping();
+
+    blocking(ring_buffer_wait_strategy::spin, 1024*1024*4, 1024, 512);
+    blocking(ring_buffer_wait_strategy::yield, 1024*1024*4, 1024, 512);
+    blocking(ring_buffer_wait_strategy::park, 1024*1024*4, 1024, 512);
+    blocking(ring_buffer_wait_strategy::hybrid, 1024*1024*4, 1024, 512);
+
+    spsc(1024*1024*16, 1024, 16);
+    spsc(1024*1024*16, 1024, 512);
+    spsc(1024*1024*16, 1024, 1024);
+
     return 0;   
 }
@@ -0,0 +1,204 @@
+/*
+    Copyright 2011 Emilio Guijarro
+
+    This file is part of the Ring Buffer library.
+
+    The Ring Buffer library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Ring Buffer library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Ring Buffer library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#pragma once
+
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+#include "ring_buffer.hpp"
+
+
+// Ring of T objects stored in properly aligned slots. Elements are moved in and out
+// rather than serialized; exceptions thrown by T's constructors and assignments
+// propagate to the caller and leave the ring consistent.
+template <typename T>
+class typed_ring_buffer {
+private:
+    // Array new only guarantees fundamental alignment before C++17
+    static_assert(alignof(T) <= alignof(std::max_align_t), "typed_ring_buffer does not support over-aligned element types");
+
+
+    typedef typename std::aligned_storage<sizeof(T), alignof(T)>::type slot;
+
+
+    std::unique_ptr<slot[]> slots;
+    size_t capacity, mask, _read, _write;
+    std::mutex mutex;
+
+
+    inline size_t ring_buffer_readable() { return _write - _read; }
+    inline size_t ring_buffer_writable() { return capacity - ring_buffer_readable(); }
+    inline size_t ring_buffer_offset(size_t position) { return (0 != mask) ? (position & mask) : (position % capacity); }
+    inline T* at(size_t position) { return reinterpret_cast<T*>(&slots[ring_buffer_offset(position)]); }
+
+
+    static const T* address(const T* items) { return items; }
+    static const T* address(std::move_iterator<T*> items) { return items.base(); }
+
+
+    // Trivially copyable elements go in with at most two memcpys, everything else is
+    // copied or moved one by one depending on the iterator
+    template <typename Iterator>
+    void push_items(Iterator items, size_t count, std::true_type) {
+        auto target = ring_buffer_offset(_write), size = std::min(count, capacity - target);
+
+        memcpy(&slots[target], address(items), size * sizeof(T));
+        memcpy(&slots[0], address(items) + size, (count - size) * sizeof(T));
+        _write += count;
+    }
+
+
+    template <typename Iterator>
+    void push_items(Iterator items, size_t count, std::false_type) {
+        for (size_t i = 0; i < count; i++, _write++, ++items)
+            new (at(_write)) T(*items);
+    }
+
+
+    template <typename Iterator>
+    size_t push_range(Iterator items, size_t count) {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto result = std::min(count, ring_buffer_writable());
+
+        push_items(items, result, typename std::is_trivially_copyable<T>::type{});
+
+        return result;
+    }
+
+
+    void pop_items(T* items, size_t count, std::true_type) {
+        auto target = ring_buffer_offset(_read), size = std::min(count, capacity - target);
+
+        memcpy(items, &slots[target], size * sizeof(T));
+        memcpy(items + size, &slots[0], (count - size) * sizeof(T));
+        _read += count;
+    }
+
+
+    void pop_items(T* items, size_t count, std::false_type) {
+        for (size_t i = 0; i < count; i++, _read++) {
+            items[i] = std::move(*at(_read));
+            at(_read)->~T();
+        }
+    }
+
+
+public:
+    typed_ring_buffer(size_t capacity) throw (ring_buffer_out_of_memory_exception) : capacity(capacity), mask((0 == (capacity & (capacity - 1))) ? capacity - 1 : 0), _read(0), _write(0) {
+        try {
+            slots.reset(new slot[capacity]);
+        } catch (std::bad_alloc&) {
+            throw ring_buffer_out_of_memory_exception{};
+        }
+    }
+
+
+    typed_ring_buffer(const typed_ring_buffer& other) = delete;
+    typed_ring_buffer& operator=(const typed_ring_buffer& other) = delete;
+
+
+    template <typename... Arguments>
+    bool try_emplace(Arguments&&... arguments) {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto result = false;
+
+        if (ring_buffer_writable() > 0) {
+            new (at(_write)) T(std::forward<Arguments>(arguments)...);
+            _write++;
+            result = true;
+        }
+
+        return result;
+    }
+
+
+    bool try_push(const T& item) { return try_emplace(item); }
+    bool try_push(T&& item) { return try_emplace(std::move(item)); }
+
+
+    bool try_pop(T& item) {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto result = false;
+
+        if (ring_buffer_readable() > 0) {
+            item = std::move(*at(_read));
+            at(_read)->~T();
+            _read++;
+            result = true;
+        }
+
+        return result;
+    }
+
+
+    template <typename... Arguments>
+    void emplace(Arguments&&... arguments) {
+        if (not try_emplace(std::forward<Arguments>(arguments)...))
+            throw ring_buffer_overflow_exception{};
+    }
+
+
+    void push(const T& item) { emplace(item); }
+    void push(T&& item) { emplace(std::move(item)); }
+
+
+    void pop(T& item) {
+        if (not try_pop(item))
+            throw ring_buffer_underflow_exception{};
+    }
+
+
+    // Bulk transfers of up to count elements, returning how many were transferred. Items
+    // are copied in, unless passed through std::make_move_iterator to move them instead.
+    size_t push_some(const T* items, size_t count) { return push_range(items, count); }
+    size_t push_some(std::move_iterator<T*> items, size_t count) { return push_range(items, count); }
+
+
+    size_t pop_some(T* items, size_t count) {
+        std::lock_guard<std::mutex> lock{mutex};
+        auto result = std::min(count, ring_buffer_readable());
+
+        pop_items(items, result, typename std::is_trivially_copyable<T>::type{});
+
+        return result;
+    }
+
+
+    void get_available(size_t& read, size_t& write) {
+        std::lock_guard<std::mutex> lock{mutex};
+
+        read = ring_buffer_readable();
+        write = ring_buffer_writable();
+    }
+
+
+    ~typed_ring_buffer() {
+        for (; _read != _write; _read++)
+            at(_read)->~T();
+    }
+};
@@ -0,0 +1,98 @@
+/*
+    Copyright 2011 Emilio Guijarro
+
+    This file is part of the Ring Buffer library.
+
+    The Ring Buffer library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Ring Buffer library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Ring Buffer library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+
+#include "ring_buffer.hpp"
+
+
+#ifndef BENCH_OPTIMIZATION
+    #define BENCH_OPTIMIZATION "unknown"
+#endif
+
+#define MAX_SAMPLES (64*1024)
+#define MAX_OPERATIONS (4*1024*1024)
+#define BYTES_PER_RUN (64*1024*1024)
+
+
+static const size_t capacities[] = { 4*1024, 64*1024, 1024*1024, 16*1024*1024 };
+static const size_t block_sizes[] = { 1, 16, 256, 4*1024, 64*1024, 1024*1024 };
+
+
+static double now() {
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return time.tv_sec * 1e9 + time.tv_nsec;
+}
+
+
+// Each operation is one write followed by one read of the same block, so the ring
+// cursors sweep the whole capacity and exercise the wrap-around path
+static void run(const size_t capacity, const size_t block_size, double* samples) {
+    ring_buffer buffer(capacity);
+    void* block = calloc(1, block_size);
+    size_t operations = std::min<size_t>(BYTES_PER_RUN / block_size, MAX_OPERATIONS), sample_count = std::min<size_t>(operations, MAX_SAMPLES);
+    double start, elapsed;
+
+    start = now();
+
+    for (size_t i = 0; i < operations; i++) {
+        buffer.write(block, block_size);
+        buffer.read(block, block_size);
+    }
+
+    elapsed = now() - start;
+
+    for (size_t i = 0; i < sample_count; i++) {
+        start = now();
+        buffer.write(block, block_size);
+        buffer.read(block, block_size);
+        samples[i] = now() - start;
+    }
+
+    std::sort(samples, samples + sample_count);
+
+    printf("C++98,%s,%lu,%lu,%lu,%.3f,%.0f,%.0f,%.0f\n", BENCH_OPTIMIZATION, static_cast<unsigned long>(capacity), static_cast<unsigned long>(block_size), static_cast<unsigned long>(operations),
+        2.0 * operations * block_size / elapsed,
+        samples[sample_count / 2], samples[sample_count * 99 / 100], samples[sample_count * 999 / 1000]);
+
+    free(block);
+}
+
+
+int main() {
+    double* samples = new double[MAX_SAMPLES];
+
+    printf("implementation,optimization,capacity,block_size,operations,throughput_gbps,p50_ns,p99_ns,p999_ns\n");
+
+    for (size_t i = 0; i < sizeof(capacities) / sizeof(capacities[0]); i++)
+        for (size_t j = 0; j < sizeof(block_sizes) / sizeof(block_sizes[0]); j++)
+            if (block_sizes[j] <= capacities[i])
+                run(capacities[i], block_sizes[j], samples);
+
+    delete[] samples;
+
+    return 0;
+}
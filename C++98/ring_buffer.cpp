@@ -23,6 +23,7 @@
 #include <cstring>
 
 #ifdef RING_BUFFER_THREAD_SAFETY
+    #include <errno.h>
     #include <pthread.h>
 #endif
 
@@ -38,8 +39,18 @@ struct ring_buffer::ring_buffer_implementation {
         pthread_mutex_t* mutex;
 
 
+        // A robust mutex whose owner died comes back with EOWNERDEAD. Cursors are only
+        // stored once data has been copied, so dropping a pending reservation or peek is
+        // enough to roll back whatever the dead owner was doing.
         lock_guard(ring_buffer_implementation* buffer) throw (ring_buffer_concurrency_error_exception) : mutex(&buffer->lock) { 
-            if (0 != pthread_mutex_lock(mutex))
+            int result = pthread_mutex_lock(mutex);
+
+            if (EOWNERDEAD == result) {
+                buffer->reserved = buffer->peeked = 0;
+                result = pthread_mutex_consistent(mutex);
+            }
+
+            if (0 != result)
                 throw ring_buffer_concurrency_error_exception();
         }
 
@@ -54,7 +65,7 @@ struct ring_buffer::ring_buffer_implementation {
     static void initialize_mutex(ring_buffer_implementation* buffer) throw (ring_buffer_concurrency_error_exception) {
         pthread_mutexattr_t attributes;
 
-        if ((0 != pthread_mutexattr_init(&attributes)) || (0 != pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE)) || (0 != pthread_mutex_init(&buffer->lock, &attributes)))
+        if ((0 != pthread_mutexattr_init(&attributes)) || (0 != pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE)) || (0 != pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST)) || (0 != pthread_mutex_init(&buffer->lock, &attributes)))
             throw ring_buffer_concurrency_error_exception();
     }
 
@@ -74,27 +85,49 @@ struct ring_buffer::ring_buffer_implementation {
     
 
     void* buffer;
-    size_t capacity, _read, _write;
+    size_t capacity, mask, _read, _write, reserved, peeked;
     _callback read_callback, write_callback;
     ring_buffer* parent;
 
 
     inline size_t ring_buffer_readable() { return _write - _read; }
     inline size_t ring_buffer_writable() { return capacity - ring_buffer_readable(); }
+    inline size_t ring_buffer_offset(size_t position) { return (0 != mask) ? (position & mask) : (position % capacity); }
+
+
+    static size_t round_up_power_of_two(size_t value) throw (ring_buffer_out_of_memory_exception) {
+        size_t result = 1;
+
+        while (result < value) {
+            // Doubling past the top bit wraps to zero; nothing that large can be allocated anyway
+            if (0 == (result << 1))
+                throw ring_buffer_out_of_memory_exception();
+
+            result <<= 1;
+        }
 
+        return result;
+    }
+
+
+    // Any power of two capacity (whether requested or not) takes the masking fast path
+    static size_t mask_for(size_t capacity) {
+        return (0 == (capacity & (capacity - 1))) ? capacity - 1 : 0;
+    }
 
-    ring_buffer_implementation(size_t capacity, ring_buffer* parent) throw (ring_buffer_concurrency_error_exception, ring_buffer_out_of_memory_exception) : capacity(capacity), _read(0), _write(0), parent(parent) {
+
+    ring_buffer_implementation(size_t capacity, const ring_buffer_attributes& attributes, ring_buffer* parent) throw (ring_buffer_concurrency_error_exception, ring_buffer_out_of_memory_exception) : capacity(attributes.power_of_two ? round_up_power_of_two(capacity) : capacity), mask(mask_for(this->capacity)), _read(0), _write(0), reserved(0), peeked(0), parent(parent) {
         initialize_mutex(this);
         read_callback.callback = write_callback.callback = 0;
 
-        if (0 == (buffer = malloc(capacity))) {
+        if (0 == (buffer = malloc(this->capacity))) {
             destroy_mutex(this);
             throw ring_buffer_out_of_memory_exception();
         }
     }
 
 
-    ring_buffer_implementation(ring_buffer_implementation* other, ring_buffer* parent) throw (ring_buffer_concurrency_error_exception, ring_buffer_out_of_memory_exception) : capacity(other->capacity), _read(other->_read), _write(other->_write), read_callback(other->read_callback), write_callback(other->write_callback), parent(parent) {
+    ring_buffer_implementation(ring_buffer_implementation* other, ring_buffer* parent) throw (ring_buffer_concurrency_error_exception, ring_buffer_out_of_memory_exception) : capacity(other->capacity), mask(other->mask), _read(other->_read), _write(other->_write), reserved(0), peeked(0), read_callback(other->read_callback), write_callback(other->write_callback), parent(parent) {
         lock_guard lock(other);
 
         initialize_mutex(this);
@@ -108,6 +141,55 @@ struct ring_buffer::ring_buffer_implementation {
     }
 
 
+    void copy_to(size_t position, const void* data, size_t length) {
+        size_t left = length;
+
+        do {
+            size_t target = ring_buffer_offset(position), size = std::min(left, capacity - target);
+
+            memcpy(reinterpret_cast<char*>(buffer) + target, reinterpret_cast<const char*>(data) + length - left, size);
+            left -= size;
+            position += size;
+        } while (left > 0);
+    }
+
+
+    void copy_from(size_t position, void* data, size_t length) {
+        size_t left = length;
+
+        do {
+            size_t target = ring_buffer_offset(position), size = std::min(left, capacity - target);
+
+            memcpy(reinterpret_cast<char*>(data) + length - left, reinterpret_cast<const char*>(buffer) + target, size);
+            left -= size;
+            position += size;
+        } while (left > 0);
+    }
+
+
+    // Describes the region starting at position as up to two spans (the second one empty unless it wraps)
+    void get_spans(size_t position, size_t length, ring_buffer_span (&spans)[2]) {
+        size_t target = ring_buffer_offset(position), size = std::min(length, capacity - target);
+
+        spans[0].data = reinterpret_cast<char*>(buffer) + target;
+        spans[0].length = size;
+        spans[1].data = buffer;
+        spans[1].length = length - size;
+    }
+
+
+    void fire_read_callback() {
+        if (read_callback.callback and (ring_buffer_readable() >= read_callback.threshold))
+            read_callback.callback(parent);
+    }
+
+
+    void fire_write_callback() {
+        if (write_callback.callback and (ring_buffer_writable() >= write_callback.threshold))
+            write_callback.callback(parent);
+    }
+
+
     void set_read_callback(ring_buffer_callback callback, size_t threshold) throw (ring_buffer_concurrency_error_exception) {
         lock_guard lock(this);
 
@@ -124,55 +206,217 @@ struct ring_buffer::ring_buffer_implementation {
     }
 
 
-    void write(const void* data, size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_overflow_exception, ring_buffer_invalid_address_exception) {
+    // Validates a scatter/gather vector and returns the number of bytes it describes
+    static size_t vector_length(const iovec* vector, int count) throw (ring_buffer_invalid_address_exception) {
+        size_t result = 0;
+
+        if ((0 > count) || ((0 == vector) && (0 < count)))
+            throw ring_buffer_invalid_address_exception();
+
+        for (int i = 0; i < count; i++)
+            if ((0 != vector[i].iov_base) || (0 == vector[i].iov_len))
+                result += vector[i].iov_len;
+            else
+                throw ring_buffer_invalid_address_exception();
+
+        return result;
+    }
+
+
+    // All segments move under one lock and callbacks fire once for the whole vector
+    void writev(const iovec* vector, int count) throw (ring_buffer_concurrency_error_exception, ring_buffer_overflow_exception, ring_buffer_invalid_address_exception) {
+        size_t length = vector_length(vector, count);
+        lock_guard lock(this);
+
+        if (ring_buffer_writable() >= length) {
+            size_t position = _write;
+
+            for (int i = 0; i < count; position += vector[i].iov_len, i++)
+                copy_to(position, vector[i].iov_base, vector[i].iov_len);
+
+            _write = position;
+            reserved = 0;
+            fire_read_callback();
+        }
+        else
+            throw ring_buffer_overflow_exception();
+    }
+
+
+    void readv(const iovec* vector, int count) throw (ring_buffer_concurrency_error_exception, ring_buffer_underflow_exception, ring_buffer_invalid_address_exception) {
+        size_t length = vector_length(vector, count);
+        lock_guard lock(this);
+
+        if (ring_buffer_readable() >= length) {
+            size_t position = _read;
+
+            for (int i = 0; i < count; position += vector[i].iov_len, i++)
+                copy_from(position, vector[i].iov_base, vector[i].iov_len);
+
+            _read = position;
+            peeked = 0;
+            fire_write_callback();
+        }
+        else
+            throw ring_buffer_underflow_exception();
+    }
+
+
+    bool try_write(const void* data, size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_invalid_address_exception) {
+        bool result = false;
+
         if (0 != data) {
             lock_guard lock(this);
 
             if (ring_buffer_writable() >= length) {
-                size_t left = length;
+                copy_to(_write, data, length);
+                _write += length;
+                reserved = 0;
+                fire_read_callback();
+                result = true;
+            }
+        }
+        else
+            throw ring_buffer_invalid_address_exception();
+
+        return result;
+    }
+
+
+    void write(const void* data, size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_overflow_exception, ring_buffer_invalid_address_exception) {
+        if (not try_write(data, length))
+            throw ring_buffer_overflow_exception();
+    }
 
-                do {
-                    size_t target = _write % capacity, size = std::min(left, capacity - target);
 
-                    memcpy(reinterpret_cast<char*>(buffer) + target, reinterpret_cast<const char*>(data) + length - left, size);
-                    left -= size;
-                    _write += size;
-                } while (left > 0);
+    bool try_read(void* data, size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_invalid_address_exception) {
+        bool result = false;
 
-                if (read_callback.callback and (ring_buffer_readable() >= read_callback.threshold))
-                    read_callback.callback(parent);
+        if (0 != data) {
+            lock_guard lock(this);
+
+            if (ring_buffer_readable() >= length) {
+                copy_from(_read, data, length);
+                _read += length;
+                peeked = 0;
+                fire_write_callback();
+                result = true;
             }
-            else
-                throw ring_buffer_overflow_exception();
         }
         else
             throw ring_buffer_invalid_address_exception();
+
+        return result;
     }
 
 
     void read(void* data, size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_underflow_exception, ring_buffer_invalid_address_exception) {
+        if (not try_read(data, length))
+            throw ring_buffer_underflow_exception();
+    }
+
+
+    // Transfers as much as fits (possibly nothing) and reports the count, like POSIX write
+    size_t write_some(const void* data, size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_invalid_address_exception) {
+        size_t result = 0;
+
         if (0 != data) {
             lock_guard lock(this);
 
-            if (ring_buffer_readable() >= length) {
-                size_t left = length;
+            if (0 < (result = std::min(length, ring_buffer_writable()))) {
+                copy_to(_write, data, result);
+                _write += result;
+                reserved = 0;
+                fire_read_callback();
+            }
+        }
+        else
+            throw ring_buffer_invalid_address_exception();
+
+        return result;
+    }
+
 
-                do {
-                    size_t target = _read % capacity, size = std::min(left, capacity - target);
+    size_t read_some(void* data, size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_invalid_address_exception) {
+        size_t result = 0;
 
-                    memcpy(reinterpret_cast<char*>(data) + length - left, reinterpret_cast<const char*>(buffer) + target, size);
-                    left -= size;
-                    _read += size;
-                } while (left > 0);
+        if (0 != data) {
+            lock_guard lock(this);
 
-                if (write_callback.callback and (ring_buffer_writable() >= write_callback.threshold))
-                    write_callback.callback(parent);
+            if (0 < (result = std::min(length, ring_buffer_readable()))) {
+                copy_from(_read, data, result);
+                _read += result;
+                peeked = 0;
+                fire_write_callback();
             }
-            else
-                throw ring_buffer_underflow_exception();
         }
         else
             throw ring_buffer_invalid_address_exception();
+
+        return result;
+    }
+
+
+    // Any other write before the commit cancels the reservation, whose spans it may overlap
+    void reserve(size_t length, ring_buffer_span (&spans)[2]) throw (ring_buffer_concurrency_error_exception, ring_buffer_overflow_exception) {
+        lock_guard lock(this);
+
+        if (ring_buffer_writable() >= length) {
+            get_spans(_write, length, spans);
+            reserved = length;
+        }
+        else
+            throw ring_buffer_overflow_exception();
+    }
+
+
+    // Committing less than the reservation publishes a prefix and drops the rest
+    void commit(size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_overflow_exception) {
+        lock_guard lock(this);
+
+        if (reserved >= length) {
+            _write += length;
+            reserved = 0;
+            fire_read_callback();
+        }
+        else
+            throw ring_buffer_overflow_exception();
+    }
+
+
+    // Any other read before the consume cancels the peek, whose spans it may have released
+    void peek(ring_buffer_span (&spans)[2]) throw (ring_buffer_concurrency_error_exception) {
+        lock_guard lock(this);
+
+        peeked = ring_buffer_readable();
+        get_spans(_read, peeked, spans);
+    }
+
+
+    // Consuming less than was peeked releases a prefix and leaves the rest readable
+    void consume(size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_underflow_exception) {
+        lock_guard lock(this);
+
+        if (peeked >= length) {
+            _read += length;
+            peeked = 0;
+            fire_write_callback();
+        }
+        else
+            throw ring_buffer_underflow_exception();
+    }
+
+
+    void skip(size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_underflow_exception) {
+        lock_guard lock(this);
+
+        if (ring_buffer_readable() >= length) {
+            _read += length;
+            peeked = 0;
+            fire_write_callback();
+        }
+        else
+            throw ring_buffer_underflow_exception();
     }
 
 
@@ -195,12 +439,24 @@ struct ring_buffer::ring_buffer_implementation {
 };
 
 
-ring_buffer::ring_buffer(size_t capacity) throw (ring_buffer_concurrency_error_exception, ring_buffer_out_of_memory_exception) : implementation(new ring_buffer_implementation(capacity, reinterpret_cast<ring_buffer*>(this))) { }
+ring_buffer::ring_buffer(size_t capacity) throw (ring_buffer_concurrency_error_exception, ring_buffer_out_of_memory_exception) : implementation(new ring_buffer_implementation(capacity, ring_buffer_attributes(), reinterpret_cast<ring_buffer*>(this))) { }
+ring_buffer::ring_buffer(size_t capacity, const ring_buffer_attributes& attributes) throw (ring_buffer_concurrency_error_exception, ring_buffer_out_of_memory_exception) : implementation(new ring_buffer_implementation(capacity, attributes, reinterpret_cast<ring_buffer*>(this))) { }
 ring_buffer::ring_buffer(ring_buffer& other) throw (ring_buffer_concurrency_error_exception, ring_buffer_out_of_memory_exception) : implementation(new ring_buffer_implementation(other.implementation, reinterpret_cast<ring_buffer*>(this))) { }
 ring_buffer& ring_buffer::operator=(ring_buffer& other) throw (ring_buffer_concurrency_error_exception, ring_buffer_out_of_memory_exception) { delete implementation; implementation = new ring_buffer_implementation(other.implementation, reinterpret_cast<ring_buffer*>(this)); return *this; }
 void ring_buffer::set_read_callback(ring_buffer_callback callback, size_t threshold) throw (ring_buffer_concurrency_error_exception) { implementation->set_read_callback(callback, threshold); }
 void ring_buffer::set_write_callback(ring_buffer_callback callback, size_t threshold) throw (ring_buffer_concurrency_error_exception) { implementation->set_write_callback(callback, threshold); }
 void ring_buffer::write(const void* data, size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_overflow_exception, ring_buffer_invalid_address_exception) { implementation->write(data, length); }
 void ring_buffer::read(void* data, size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_underflow_exception, ring_buffer_invalid_address_exception) { implementation->read(data, length); }
+void ring_buffer::writev(const iovec* vector, int count) throw (ring_buffer_concurrency_error_exception, ring_buffer_overflow_exception, ring_buffer_invalid_address_exception) { implementation->writev(vector, count); }
+void ring_buffer::readv(const iovec* vector, int count) throw (ring_buffer_concurrency_error_exception, ring_buffer_underflow_exception, ring_buffer_invalid_address_exception) { implementation->readv(vector, count); }
+bool ring_buffer::try_write(const void* data, size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_invalid_address_exception) { return implementation->try_write(data, length); }
+bool ring_buffer::try_read(void* data, size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_invalid_address_exception) { return implementation->try_read(data, length); }
+size_t ring_buffer::write_some(const void* data, size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_invalid_address_exception) { return implementation->write_some(data, length); }
+size_t ring_buffer::read_some(void* data, size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_invalid_address_exception) { return implementation->read_some(data, length); }
+void ring_buffer::reserve(size_t length, ring_buffer_span (&spans)[2]) throw (ring_buffer_concurrency_error_exception, ring_buffer_overflow_exception) { implementation->reserve(length, spans); }
+void ring_buffer::commit(size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_overflow_exception) { implementation->commit(length); }
+void ring_buffer::peek(ring_buffer_span (&spans)[2]) throw (ring_buffer_concurrency_error_exception) { implementation->peek(spans); }
+void ring_buffer::consume(size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_underflow_exception) { implementation->consume(length); }
+void ring_buffer::skip(size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_underflow_exception) { implementation->skip(length); }
 void ring_buffer::get_available(size_t& read, size_t& write) throw (ring_buffer_concurrency_error_exception) { implementation->get_available(read, write); }
 ring_buffer::~ring_buffer() throw (ring_buffer_concurrency_error_exception) { delete implementation; }
@@ -22,6 +22,7 @@
 
 
 #include <cstddef>
+#include <sys/uio.h>
 
 
 struct ring_buffer_exception { };
@@ -31,6 +32,19 @@ struct ring_buffer_overflow_exception : ring_buffer_exception { };
 struct ring_buffer_underflow_exception : ring_buffer_exception { };
 struct ring_buffer_concurrency_error_exception : ring_buffer_exception { };
 
+struct ring_buffer_attributes {
+    bool power_of_two; // Round capacity up to a power of two so positions are masked instead of divided
+
+
+    ring_buffer_attributes() : power_of_two(false) { }
+};
+
+
+struct ring_buffer_span {
+    void* data;
+    size_t length;
+};
+
 
 class ring_buffer {
 private:
@@ -42,12 +56,24 @@ public:
 
 
     ring_buffer(size_t capacity) throw (ring_buffer_concurrency_error_exception, ring_buffer_out_of_memory_exception);
+    ring_buffer(size_t capacity, const ring_buffer_attributes& attributes) throw (ring_buffer_concurrency_error_exception, ring_buffer_out_of_memory_exception);
     ring_buffer(ring_buffer& other) throw (ring_buffer_concurrency_error_exception, ring_buffer_out_of_memory_exception);
     ring_buffer& operator=(ring_buffer& other) throw (ring_buffer_concurrency_error_exception, ring_buffer_out_of_memory_exception);
     void set_read_callback(ring_buffer_callback callback, size_t threshold) throw (ring_buffer_concurrency_error_exception);
     void set_write_callback(ring_buffer_callback callback, size_t threshold) throw (ring_buffer_concurrency_error_exception);
     void write(const void* data, size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_overflow_exception, ring_buffer_invalid_address_exception);
     void read(void* data, size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_underflow_exception, ring_buffer_invalid_address_exception);
+    void writev(const iovec* vector, int count) throw (ring_buffer_concurrency_error_exception, ring_buffer_overflow_exception, ring_buffer_invalid_address_exception);
+    void readv(const iovec* vector, int count) throw (ring_buffer_concurrency_error_exception, ring_buffer_underflow_exception, ring_buffer_invalid_address_exception);
+    bool try_write(const void* data, size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_invalid_address_exception);
+    bool try_read(void* data, size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_invalid_address_exception);
+    size_t write_some(const void* data, size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_invalid_address_exception);
+    size_t read_some(void* data, size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_invalid_address_exception);
+    void reserve(size_t length, ring_buffer_span (&spans)[2]) throw (ring_buffer_concurrency_error_exception, ring_buffer_overflow_exception);
+    void commit(size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_overflow_exception);
+    void peek(ring_buffer_span (&spans)[2]) throw (ring_buffer_concurrency_error_exception);
+    void consume(size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_underflow_exception);
+    void skip(size_t length) throw (ring_buffer_concurrency_error_exception, ring_buffer_underflow_exception);
     void get_available(size_t& read, size_t& write) throw (ring_buffer_concurrency_error_exception);
     ~ring_buffer() throw (ring_buffer_concurrency_error_exception);
 };
@@ -18,6 +18,7 @@
 */
 
 
+#include <algorithm>
 #include <cassert>
 #include <cstdlib>
 
@@ -233,6 +234,298 @@ static void interleaved(const size_t byte_count, const size_t ring_buffer_size,
 }
 
 
+static void power_of_two(const size_t byte_count, const size_t max_block_size) {
+    try {
+        ring_buffer_attributes attributes;
+
+        attributes.power_of_two = true;
+
+        ring_buffer buffer(1000, attributes);
+        void* temp_buffer = malloc(max_block_size);
+        size_t count = 0, read, write;
+
+        buffer.get_available(read, write);
+        assert((read == 0) && (write == 1024));
+        sync();
+
+        while (count < byte_count) {
+            size_t length = rand() % max_block_size;
+
+            produce(temp_buffer, length);
+
+            try {
+                buffer.write(temp_buffer, length);
+            } catch (ring_buffer_overflow_exception) {
+                revert(length);
+            }
+
+            length = rand() % max_block_size;
+
+            try {
+                buffer.read(temp_buffer, length);
+            } catch (ring_buffer_underflow_exception) {
+                continue;
+            }
+
+            verify(temp_buffer, length);
+            count += length;
+        }
+
+        free(temp_buffer);
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+
+    // No power of two at or above this capacity fits in a size_t
+    try {
+        ring_buffer_attributes attributes;
+
+        attributes.power_of_two = true;
+
+        ring_buffer buffer(static_cast<size_t>(-1), attributes);
+        assert(false);
+    } catch (ring_buffer_out_of_memory_exception) {
+    }
+}
+
+
+static void partial(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    try {
+        ring_buffer buffer(ring_buffer_size);
+        void* temp_buffer = malloc(max_block_size);
+        size_t count = 0;
+
+        assert(0 == buffer.read_some(temp_buffer, max_block_size));
+        sync();
+
+        while (count < byte_count) {
+            size_t length = rand() % max_block_size, transferred;
+
+            produce(temp_buffer, length);
+            transferred = buffer.write_some(temp_buffer, length);
+            assert(transferred <= length);
+            revert(length - transferred);
+
+            length = rand() % max_block_size;
+            transferred = buffer.read_some(temp_buffer, length);
+            assert(transferred <= length);
+            verify(temp_buffer, transferred);
+            count += transferred;
+        }
+
+        free(temp_buffer);
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
+// Blocks are split into three segments at random points on both sides
+static void split(iovec (&vector)[3], void* data, size_t length) {
+    size_t first = rand() % (length + 1), second = first + rand() % (length - first + 1);
+
+    vector[0].iov_base = data;
+    vector[0].iov_len = first;
+    vector[1].iov_base = static_cast<char*>(data) + first;
+    vector[1].iov_len = second - first;
+    vector[2].iov_base = static_cast<char*>(data) + second;
+    vector[2].iov_len = length - second;
+}
+
+
+static void vectored(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    try {
+        ring_buffer buffer(ring_buffer_size);
+        iovec vector[3];
+        void* temp_buffer = malloc(max_block_size);
+        size_t count = 0;
+
+        try { buffer.writev(0, 1); assert(false); } catch (ring_buffer_invalid_address_exception) { }
+        sync();
+
+        while (count < byte_count) {
+            size_t length = rand() % max_block_size;
+
+            produce(temp_buffer, length);
+            split(vector, temp_buffer, length);
+
+            try {
+                buffer.writev(vector, 3);
+            } catch (ring_buffer_overflow_exception) {
+                revert(length);
+            }
+
+            length = rand() % max_block_size;
+            split(vector, temp_buffer, length);
+
+            try {
+                buffer.readv(vector, 3);
+            } catch (ring_buffer_underflow_exception) {
+                continue;
+            }
+
+            verify(temp_buffer, length);
+            count += length;
+        }
+
+        free(temp_buffer);
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
+static void reserve_commit(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    try {
+        ring_buffer buffer(ring_buffer_size);
+        ring_buffer_span spans[2];
+        void* temp_buffer = malloc(max_block_size);
+        size_t count = 0, read, write;
+
+        try { buffer.reserve(ring_buffer_size + 1, spans); assert(false); } catch (ring_buffer_overflow_exception) { }
+        try { buffer.commit(1); assert(false); } catch (ring_buffer_overflow_exception) { }
+        sync();
+
+        while (count < byte_count) {
+            size_t length = rand() % max_block_size;
+
+            try {
+                buffer.reserve(length, spans);
+                assert(spans[0].length + spans[1].length == length);
+                produce(spans[0].data, spans[0].length);
+                produce(spans[1].data, spans[1].length);
+                buffer.commit(length);
+            } catch (ring_buffer_overflow_exception) { }
+
+            length = rand() % max_block_size;
+
+            try {
+                buffer.read(temp_buffer, length);
+            } catch (ring_buffer_underflow_exception) {
+                continue;
+            }
+
+            verify(temp_buffer, length);
+            count += length;
+        }
+
+        // A partial commit only publishes the leading bytes of the reservation
+        buffer.get_available(read, write);
+        buffer.reserve(write, spans);
+        buffer.commit(1);
+        buffer.get_available(count, write);
+        assert(count == read + 1);
+        try { buffer.commit(1); assert(false); } catch (ring_buffer_overflow_exception) { }
+
+        // A write in between cancels the reservation instead of publishing bytes nobody wrote
+        buffer.get_available(read, write);
+        buffer.skip(read);
+        buffer.reserve(ring_buffer_size, spans);
+        buffer.write(temp_buffer, 1);
+        try { buffer.commit(ring_buffer_size); assert(false); } catch (ring_buffer_overflow_exception) { }
+        buffer.get_available(read, write);
+        assert(read == 1);
+
+        free(temp_buffer);
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
+static void peek_consume(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    try {
+        ring_buffer buffer(ring_buffer_size);
+        ring_buffer_span spans[2];
+        void* temp_buffer = malloc(max_block_size);
+        size_t count = 0, read, write;
+
+        buffer.peek(spans);
+        assert((spans[0].length == 0) && (spans[1].length == 0));
+        try { buffer.consume(1); assert(false); } catch (ring_buffer_underflow_exception) { }
+        try { buffer.skip(1); assert(false); } catch (ring_buffer_underflow_exception) { }
+        sync();
+
+        while (count < byte_count) {
+            size_t length = rand() % max_block_size;
+
+            produce(temp_buffer, length);
+
+            try {
+                buffer.write(temp_buffer, length);
+            } catch (ring_buffer_overflow_exception) {
+                revert(length);
+            }
+
+            buffer.peek(spans);
+            length = std::min<size_t>(rand() % max_block_size, spans[0].length + spans[1].length);
+
+            // Alternate between verifying in place and discarding without a copy
+            if (rand() % 2) {
+                size_t head = std::min(length, spans[0].length);
+
+                verify(spans[0].data, head);
+                verify(spans[1].data, length - head);
+                buffer.consume(length);
+            }
+            else {
+                read_counter += length;
+                buffer.skip(length);
+            }
+
+            count += length;
+        }
+
+        // A read in between cancels the peek instead of releasing bytes twice
+        buffer.get_available(read, write);
+        buffer.skip(read);
+        buffer.write(temp_buffer, 2);
+        buffer.peek(spans);
+        buffer.skip(1);
+        try { buffer.consume(2); assert(false); } catch (ring_buffer_underflow_exception) { }
+        buffer.get_available(read, write);
+        assert(read == 1);
+
+        free(temp_buffer);
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
+static void nonthrowing(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    try {
+        ring_buffer buffer(ring_buffer_size);
+        void* temp_buffer = malloc(max_block_size);
+        size_t count = 0;
+
+        assert(not buffer.try_read(temp_buffer, 1));
+        assert(not buffer.try_write(temp_buffer, ring_buffer_size + 1));
+        sync();
+
+        while (count < byte_count) {
+            size_t length = rand() % max_block_size;
+
+            produce(temp_buffer, length);
+
+            if (not buffer.try_write(temp_buffer, length))
+                revert(length);
+
+            length = rand() % max_block_size;
+
+            if (buffer.try_read(temp_buffer, length)) {
+                verify(temp_buffer, length);
+                count += length;
+            }
+        }
+
+        free(temp_buffer);
+    } catch (ring_buffer_exception) {
+        assert(false);
+    }
+}
+
+
 static void huge() {
     try {
         const size_t buffer_size = 1024*1024;
@@ -265,6 +558,24 @@ int main() {
     interleaved(1024*1024*16, 1024, 512);
     interleaved(1024*1024*16, 1024, 1024);
     
+    power_of_two(1024*1024*16, 16);
+    power_of_two(1024*1024*16, 1024);
+
+    nonthrowing(1024*1024*16, 1024, 16);
+    nonthrowing(1024*1024*16, 1024, 1024);
+
+    partial(1024*1024*16, 1000, 16);
+    partial(1024*1024*16, 1000, 2048);
+
+    vectored(1024*1024*16, 1000, 16);
+    vectored(1024*1024*16, 1000, 512);
+
+    reserve_commit(1024*1024*16, 1000, 16);
+    reserve_commit(1024*1024*16, 1000, 512);
+
+    peek_consume(1024*1024*16, 1000, 16);
+    peek_consume(1024*1024*16, 1000, 512);
+
     huge();
 
     return 0;   
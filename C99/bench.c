@@ -0,0 +1,118 @@
+/*
+    Copyright 2011 Emilio Guijarro
+
+    This file is part of the Ring Buffer library.
+
+    The Ring Buffer library is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    The Ring Buffer library is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with the Ring Buffer library.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "ring_buffer.h"
+
+
+#ifndef BENCH_OPTIMIZATION
+    #define BENCH_OPTIMIZATION "unknown"
+#endif
+
+#define MAX_SAMPLES (64*1024)
+#define MAX_OPERATIONS (4*1024*1024)
+#define BYTES_PER_RUN (64*1024*1024)
+
+
+static const size_t capacities[] = { 4*1024, 64*1024, 1024*1024, 16*1024*1024 };
+static const size_t block_sizes[] = { 1, 16, 256, 4*1024, 64*1024, 1024*1024 };
+
+
+static double now() {
+    struct timespec time;
+
+    clock_gettime(CLOCK_MONOTONIC, &time);
+
+    return time.tv_sec * 1e9 + time.tv_nsec;
+}
+
+
+// Aborts the run rather than timing operations that did nothing
+static void check(ring_buffer_status status) {
+    if (RING_BUFFER_SUCCESS != status) {
+        fprintf(stderr, "ring buffer operation failed with status %d\n", status);
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+static int compare(const void* a, const void* b) {
+    double x = *(const double*)a, y = *(const double*)b;
+
+    return (x > y) - (x < y);
+}
+
+
+// Each operation is one write followed by one read of the same block, so the ring
+// cursors sweep the whole capacity and exercise the wrap-around path
+static void run(const size_t capacity, const size_t block_size, double* samples) {
+    ring_buffer* buffer;
+    void* block = calloc(1, block_size);
+    size_t operations = (BYTES_PER_RUN / block_size < MAX_OPERATIONS) ? BYTES_PER_RUN / block_size : MAX_OPERATIONS;
+    size_t sample_count = (operations < MAX_SAMPLES) ? operations : MAX_SAMPLES;
+    double start, elapsed;
+
+    check(ring_buffer_create(&buffer, capacity));
+
+    start = now();
+
+    for (size_t i = 0; i < operations; i++) {
+        check(ring_buffer_write(buffer, block, block_size));
+        check(ring_buffer_read(buffer, block, block_size));
+    }
+
+    elapsed = now() - start;
+
+    for (size_t i = 0; i < sample_count; i++) {
+        start = now();
+        check(ring_buffer_write(buffer, block, block_size));
+        check(ring_buffer_read(buffer, block, block_size));
+        samples[i] = now() - start;
+    }
+
+    qsort(samples, sample_count, sizeof(double), compare);
+
+    printf("C99,%s,%zu,%zu,%zu,%.3f,%.0f,%.0f,%.0f\n", BENCH_OPTIMIZATION, capacity, block_size, operations,
+        2.0 * operations * block_size / elapsed,
+        samples[sample_count / 2], samples[sample_count * 99 / 100], samples[sample_count * 999 / 1000]);
+
+    check(ring_buffer_destroy(buffer));
+    free(block);
+}
+
+
+int main() {
+    double* samples = malloc(MAX_SAMPLES * sizeof(double));
+
+    printf("implementation,optimization,capacity,block_size,operations,throughput_gbps,p50_ns,p99_ns,p999_ns\n");
+
+    for (size_t i = 0; i < sizeof(capacities) / sizeof(capacities[0]); i++)
+        for (size_t j = 0; j < sizeof(block_sizes) / sizeof(block_sizes[0]); j++)
+            if (block_sizes[j] <= capacities[i])
+                run(capacities[i], block_sizes[j], samples);
+
+    free(samples);
+
+    return 0;
+}
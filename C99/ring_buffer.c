@@ -18,17 +18,29 @@
 */
 
 
+#define _GNU_SOURCE
+
 #include "ring_buffer.h"
 
+#include <errno.h>
+#include <fcntl.h>
+#include <linux/mempolicy.h>
+#include <sched.h>
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
 
 #ifdef RING_BUFFER_THREAD_SAFETY
-    #define __USE_UNIX98
     #include <pthread.h>
 
-    #define ENTER_CRITICAL(ring) if (0 == pthread_mutex_lock(&ring->lock)) {
-    #define EXIT_CRITICAL(ring, result) pthread_mutex_unlock(&ring->lock); } else result = RING_BUFFER_CONCURRENCY_ERROR
+    #define ENTER_CRITICAL(ring) if (0 == lock_state(ring->state)) {
+    #define EXIT_CRITICAL(ring, result) pthread_mutex_unlock(&ring->state->lock); } else result = RING_BUFFER_CONCURRENCY_ERROR
 #else
     #define pthread_mutex_init(mutex, attr) 0
     #define pthread_mutex_lock(mutex) 0
@@ -36,15 +48,27 @@
     #define pthread_mutex_destroy(mutex)
     #define pthread_mutexattr_init(attr) 0
     #define pthread_mutexattr_settype(attr, type) 0
+    #define pthread_mutexattr_setpshared(attr, pshared) 0
+    #define pthread_mutexattr_setrobust(attr, robust) 0
+    #define lock_state(state) 0
     
     #define ENTER_CRITICAL(ring)
     #define EXIT_CRITICAL(ring, result)
 #endif
 
 
+#define RING_BUFFER_CACHE_LINE_SIZE 64
+#define RING_BUFFER_CACHE_ALIGNED __attribute__((aligned(RING_BUFFER_CACHE_LINE_SIZE)))
+#define RING_BUFFER_HUGE_PAGE_SIZE (2*1024*1024)
+#define RING_BUFFER_MAX_NUMA_NODES 1024
+#define RING_BUFFER_PLACEMENT (RING_BUFFER_HUGE_PAGES | RING_BUFFER_LOCKED | RING_BUFFER_PREFAULT)
+
+
 #define min(a, b) (((a) < (b)) ? (a) : (b))
-#define ring_buffer_readable(ring) (ring->write - ring->read)
-#define ring_buffer_writable(ring) (ring->capacity - ring_buffer_readable(ring))
+#define ring_buffer_readable(ring) (ring->state->write - ring->state->read)
+#define ring_buffer_writable(ring) (ring->capacity - ring_buffer_readable(ring) - ring->state->spliced)
+#define ring_buffer_offset(ring, position) ((0 != ring->mask) ? ((position) & ring->mask) : ((position) % ring->capacity))
+#define ring_buffer_shared(ring) (&ring->local != ring->state)
             
 
 struct _callback {
@@ -52,149 +76,503 @@ struct _callback {
     size_t threshold;
 };
 
+struct _event {
+    int fd;
+    size_t threshold;
+    int signalled;
+};
+
 
-struct _ring_buffer {
-    void* buffer;
-    size_t capacity, read, write;
+// Cursors and lock, with producer and consumer state on cache lines of their own so
+// that concurrent writers and readers do not keep invalidating each other's line. A
+// private ring embeds this block; a shared ring keeps it at the start of the shared
+// memory object, ahead of the data, so it must never hold pointers.
+struct _ring_buffer_state {
+    size_t capacity;
 #ifdef RING_BUFFER_THREAD_SAFETY
     pthread_mutex_t lock;
 #endif
+
+    size_t write RING_BUFFER_CACHE_ALIGNED, reserved;
+    size_t read RING_BUFFER_CACHE_ALIGNED, peeked, spliced;
+} RING_BUFFER_CACHE_ALIGNED;
+
+
+#ifdef RING_BUFFER_THREAD_SAFETY
+// A robust lock whose owner died (possibly in another process) comes back with
+// EOWNERDEAD. Cursors are only stored once data has been copied, so the interrupted
+// transfer never became visible; dropping a pending reservation or peek rolls back
+// anything else the owner had started.
+static int lock_state(struct _ring_buffer_state* state) {
+    int result = pthread_mutex_lock(&state->lock);
+
+    if (EOWNERDEAD == result) {
+        state->reserved = state->peeked = 0;
+        result = pthread_mutex_consistent(&state->lock);
+    }
+
+    return result;
+}
+#endif
+
+
+struct _ring_buffer {
+    void* buffer;
+    size_t capacity, mask, mapped;
+    unsigned int flags;
+    struct _ring_buffer_state* state;
+    ring_buffer_allocator allocator;
     struct _callback read_callback, write_callback;
+    struct _event read_event, write_event;
+    struct _ring_buffer_state local;
 };
 
 
-ring_buffer_status ring_buffer_create(ring_buffer** ring, size_t capacity) {
+static void* default_allocate(void* context, size_t size, size_t alignment) {
+    void* result;
+
+    return (0 == posix_memalign(&result, alignment, size)) ? result : NULL;
+}
+
+
+static void default_deallocate(void* context, void* data, size_t size) {
+    free(data);
+}
+
+
+static const ring_buffer_allocator default_allocator = { default_allocate, default_deallocate, NULL };
+
+
+// The ring keeps a copy of its allocator, so it has to be read out before the ring
+// itself goes back to it
+static void free_ring(struct _ring_buffer* ring) {
+    ring_buffer_allocator allocator = ring->allocator;
+
+    allocator.deallocate(allocator.context, ring, sizeof(struct _ring_buffer));
+}
+
+
+// Storage pages are only allocated when first touched, so the NUMA policy and huge page
+// advice go in before anything else; locking and prefaulting then fault everything in
+// up front instead of on the first writes
+static ring_buffer_status place_buffer(struct _ring_buffer* ring, char* base, size_t length, int node) {
     ring_buffer_status result = RING_BUFFER_SUCCESS;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    unsigned long nodes[RING_BUFFER_MAX_NUMA_NODES / (8 * sizeof(unsigned long))] = { 0 };
+    unsigned int cpu, local;
 
-    if (NULL != ring) {
-        struct _ring_buffer* _ring;
-        
-        if (NULL != (_ring = (struct _ring_buffer*)malloc(sizeof(struct _ring_buffer)))) {
-            if (NULL != (_ring->buffer = malloc(capacity))) {
-#ifdef RING_BUFFER_THREAD_SAFETY
-                pthread_mutexattr_t attributes;
-#endif
+    // Advice only: hugetlb mappings reject it and that is fine
+    if (ring->flags & RING_BUFFER_HUGE_PAGES)
+        madvise(base, length, MADV_HUGEPAGE);
 
-                if ((0 == pthread_mutexattr_init(&attributes)) && (0 == pthread_mutexattr_settype(&attributes, PTHREAD_MUTEX_RECURSIVE)) && (0 == pthread_mutex_init(&_ring->lock, &attributes))) {
-                    _ring->capacity = capacity;
-                    _ring->read = _ring->write = 0;
-                    _ring->read_callback.callback = _ring->write_callback.callback = NULL;
-                    *ring = _ring;
+    if (RING_BUFFER_NUMA_LOCAL == node) {
+        if (0 == getcpu(&cpu, &local))
+            node = local;
+        else
+            result = RING_BUFFER_SYSTEM_ERROR;
+    }
+
+    if ((RING_BUFFER_SUCCESS == result) && (0 <= node)) {
+        if (node < RING_BUFFER_MAX_NUMA_NODES) {
+            nodes[node / (8 * sizeof(unsigned long))] = 1UL << (node % (8 * sizeof(unsigned long)));
+
+            if (0 != syscall(SYS_mbind, base, length, MPOL_BIND, nodes, RING_BUFFER_MAX_NUMA_NODES + 1, 0))
+                result = RING_BUFFER_SYSTEM_ERROR;
+        }
+        else {
+            errno = EINVAL;
+            result = RING_BUFFER_SYSTEM_ERROR;
+        }
+    }
+
+    if ((RING_BUFFER_SUCCESS == result) && (ring->flags & RING_BUFFER_LOCKED) && (0 != mlock(base, length)))
+        result = RING_BUFFER_SYSTEM_ERROR;
+
+    if ((RING_BUFFER_SUCCESS == result) && (ring->flags & RING_BUFFER_PREFAULT))
+        for (size_t i = 0; i < length; i += page)
+            ((volatile char*)base)[i] = 0;
+
+    return result;
+}
+
+
+// Maps a memory file of the given capacity twice back to back. Hugetlb files can only
+// be mapped at huge page boundaries, so the reservation is aligned and then trimmed.
+static ring_buffer_status map_mirrored(struct _ring_buffer* ring, size_t capacity, size_t alignment, unsigned int memfd_flags) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+    int fd;
+
+    if (-1 != (fd = memfd_create("ring_buffer", MFD_CLOEXEC | memfd_flags))) {
+        if (0 == ftruncate(fd, capacity)) {
+            char* reservation = mmap(NULL, 2 * capacity + alignment, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+            if (MAP_FAILED != reservation) {
+                char* base = (char*)(((uintptr_t)reservation + alignment - 1) / alignment * alignment);
+
+                if (base > reservation)
+                    munmap(reservation, base - reservation);
+
+                munmap(base + 2 * capacity, reservation + alignment - base);
+
+                if ((MAP_FAILED != mmap(base, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0)) && (MAP_FAILED != mmap(base + capacity, capacity, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0))) {
+                    ring->buffer = base;
+                    ring->capacity = capacity;
                 }
                 else {
-                    free(_ring->buffer);
-                    free(_ring);
-                    result = RING_BUFFER_CONCURRENCY_ERROR;
+                    munmap(base, 2 * capacity);
+                    result = RING_BUFFER_OUT_OF_MEMORY;
                 }
             }
-            else {
-                free(_ring);
+            else
                 result = RING_BUFFER_OUT_OF_MEMORY;
-            }
         }
         else
+            result = RING_BUFFER_SYSTEM_ERROR;
+
+        close(fd);
+    }
+    else
+        result = RING_BUFFER_SYSTEM_ERROR;
+
+    return result;
+}
+
+
+static ring_buffer_status allocate_mirrored(struct _ring_buffer* ring, int node) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE), huge_page = RING_BUFFER_HUGE_PAGE_SIZE;
+
+    // Both views share the same pages, so the size has to be a whole number of them
+    size_t capacity = ((ring->capacity + page - 1) / page) * page;
+
+    if (0 == capacity)
+        capacity = page;
+
+    // Without a huge page pool fall back to regular pages and leave it to the advice
+    if (!(ring->flags & RING_BUFFER_HUGE_PAGES) || (RING_BUFFER_SUCCESS != map_mirrored(ring, ((capacity + huge_page - 1) / huge_page) * huge_page, huge_page, MFD_HUGETLB)))
+        result = map_mirrored(ring, capacity, page, 0);
+
+    if ((RING_BUFFER_SUCCESS == result) && (RING_BUFFER_SUCCESS != (result = place_buffer(ring, ring->buffer, 2 * ring->capacity, node))))
+        munmap(ring->buffer, 2 * ring->capacity);
+
+    return result;
+}
+
+
+// Storage with placement attributes comes straight from mmap instead of the allocator, so
+// that it is page aligned and owned by this ring alone. Even an empty ring maps a page, and
+// mapped always holds the length actually mapped, which is what gets unmapped.
+static ring_buffer_status allocate_mapped(struct _ring_buffer* ring, int node) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+    size_t page = (size_t)sysconf(_SC_PAGESIZE), huge_page = RING_BUFFER_HUGE_PAGE_SIZE;
+    size_t length = (0 < ring->capacity) ? ring->capacity : 1;
+    char* base = MAP_FAILED;
+
+    ring->mapped = ((length + huge_page - 1) / huge_page) * huge_page;
+
+    if (ring->flags & RING_BUFFER_HUGE_PAGES)
+        base = mmap(NULL, ring->mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+    if (MAP_FAILED == base) {
+        ring->mapped = ((length + page - 1) / page) * page;
+        base = mmap(NULL, ring->mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    }
+
+    if (MAP_FAILED != base) {
+        if (RING_BUFFER_SUCCESS == (result = place_buffer(ring, base, ring->mapped, node)))
+            ring->buffer = base;
+        else
+            munmap(base, ring->mapped);
+    }
+    else
+        result = RING_BUFFER_OUT_OF_MEMORY;
+
+    return result;
+}
+
+
+static ring_buffer_status allocate_buffer(struct _ring_buffer* ring, int node) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if (ring->flags & RING_BUFFER_POWER_OF_TWO) {
+        size_t capacity = 1;
+
+        // Doubling past the top bit wraps to zero; nothing that large can be allocated anyway
+        while ((capacity < ring->capacity) && (0 != (capacity << 1)))
+            capacity <<= 1;
+
+        if (capacity < ring->capacity)
+            result = RING_BUFFER_OUT_OF_MEMORY;
+        else
+            ring->capacity = capacity;
+    }
+
+    ring->mapped = 0;
+
+    if (RING_BUFFER_SUCCESS == result) {
+        if (ring->flags & RING_BUFFER_MIRRORED)
+            result = allocate_mirrored(ring, node);
+        else if ((ring->flags & RING_BUFFER_PLACEMENT) || (RING_BUFFER_NUMA_ANY != node))
+            result = allocate_mapped(ring, node);
+        else if (NULL == (ring->buffer = ring->allocator.allocate(ring->allocator.context, ring->capacity, RING_BUFFER_CACHE_LINE_SIZE)))
             result = RING_BUFFER_OUT_OF_MEMORY;
     }
+
+    // Any power of two capacity (whether requested or not) takes the masking fast path
+    ring->mask = (0 == (ring->capacity & (ring->capacity - 1))) ? ring->capacity - 1 : 0;
+
+    return result;
+}
+
+
+// A shared memory object starts with the state block, padded to a whole page so the
+// data area that follows it stays page aligned
+static size_t shared_offset() {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+
+    return ((sizeof(struct _ring_buffer_state) + page - 1) / page) * page;
+}
+
+
+static ring_buffer_status map_shared(struct _ring_buffer* ring, int fd, size_t capacity) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+    char* base = mmap(NULL, shared_offset() + capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+
+    if (MAP_FAILED != base) {
+        ring->state = (struct _ring_buffer_state*)base;
+        ring->buffer = base + shared_offset();
+        ring->capacity = capacity;
+        ring->mask = (0 == (capacity & (capacity - 1))) ? capacity - 1 : 0;
+        ring->flags = 0;
+    }
     else
-        result = RING_BUFFER_INVALID_ADDRESS;
-    
+        result = RING_BUFFER_SYSTEM_ERROR;
+
     return result;
 }
 
 
-ring_buffer_status ring_buffer_set_read_callback(ring_buffer* ring, ring_buffer_callback callback, size_t threshold)
-{
+static void release_buffer(struct _ring_buffer* ring) {
+    if (ring_buffer_shared(ring))
+        munmap(ring->state, shared_offset() + ring->capacity);
+    else if (ring->flags & RING_BUFFER_MIRRORED)
+        munmap(ring->buffer, 2 * ring->capacity);
+    else if (0 != ring->mapped)
+        munmap(ring->buffer, ring->mapped);
+    else
+        ring->allocator.deallocate(ring->allocator.context, ring->buffer, ring->capacity);
+}
+
+
+// A mirrored buffer exposes every region as a single span, otherwise copies may wrap once
+static inline void copy_to(struct _ring_buffer* ring, size_t position, const void* data, size_t length) {
+    size_t target = ring_buffer_offset(ring, position);
+
+    if (ring->flags & RING_BUFFER_MIRRORED)
+        memcpy((char*)ring->buffer + target, data, length);
+    else {
+        size_t size = min(length, ring->capacity - target);
+
+        memcpy((char*)ring->buffer + target, data, size);
+
+        if (size < length)
+            memcpy(ring->buffer, (const char*)data + size, length - size);
+    }
+}
+
+
+static inline void copy_from(struct _ring_buffer* ring, size_t position, void* data, size_t length) {
+    size_t target = ring_buffer_offset(ring, position);
+
+    if (ring->flags & RING_BUFFER_MIRRORED)
+        memcpy(data, (const char*)ring->buffer + target, length);
+    else {
+        size_t size = min(length, ring->capacity - target);
+
+        memcpy(data, (const char*)ring->buffer + target, size);
+
+        if (size < length)
+            memcpy((char*)data + size, ring->buffer, length - size);
+    }
+}
+
+
+// Describes the region starting at position as up to two spans (the second one empty unless it wraps)
+static inline void get_spans(struct _ring_buffer* ring, size_t position, size_t length, ring_buffer_span spans[2]) {
+    size_t target = ring_buffer_offset(ring, position), size = (ring->flags & RING_BUFFER_MIRRORED) ? length : min(length, ring->capacity - target);
+
+    spans[0].data = (char*)ring->buffer + target;
+    spans[0].length = size;
+    spans[1].data = ring->buffer;
+    spans[1].length = length - size;
+}
+
+
+// Turns the spans of a region into the iovec array the scatter/gather syscalls take
+static inline int get_vector(struct _ring_buffer* ring, size_t position, size_t length, struct iovec vector[2]) {
+    ring_buffer_span spans[2];
+
+    get_spans(ring, position, length, spans);
+    vector[0].iov_base = spans[0].data;
+    vector[0].iov_len = spans[0].length;
+    vector[1].iov_base = spans[1].data;
+    vector[1].iov_len = spans[1].length;
+
+    return (0 < spans[1].length) ? 2 : 1;
+}
+
+
+// Events are edge-triggered: the eventfd is signalled once when the level reaches the
+// threshold and rearmed only after the level has dropped below it again
+static inline void update_event(struct _event* event, size_t level) {
+    if (level < event->threshold)
+        event->signalled = 0;
+    else if ((-1 != event->fd) && !event->signalled) {
+        uint64_t value = 1;
+
+        event->signalled = (sizeof(value) == write(event->fd, &value, sizeof(value)));
+    }
+}
+
+
+static inline void update_events(struct _ring_buffer* ring) {
+    update_event(&ring->read_event, ring_buffer_readable(ring));
+    update_event(&ring->write_event, ring_buffer_writable(ring));
+}
+
+
+// The descriptor belongs to the ring and is closed on destruction; setting it again
+// keeps the same descriptor and only changes the threshold
+static ring_buffer_status set_event(struct _event* event, size_t threshold, int* fd) {
     ring_buffer_status result = RING_BUFFER_SUCCESS;
 
-    if (NULL != ring) {
-        ENTER_CRITICAL(ring);
-        
-        ring->read_callback.callback = callback;
-        ring->read_callback.threshold = threshold;
-        
-        EXIT_CRITICAL(ring, result);
+    if ((-1 != event->fd) || (-1 != (event->fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)))) {
+        event->threshold = threshold;
+        event->signalled = 0;
+        *fd = event->fd;
     }
     else
-        result = RING_BUFFER_INVALID_ADDRESS;
-    
+        result = RING_BUFFER_SYSTEM_ERROR;
+
     return result;
 }
 
 
-ring_buffer_status ring_buffer_set_write_callback(ring_buffer* ring, ring_buffer_callback callback, size_t threshold) {
+// Validates a scatter/gather vector and adds up the number of bytes it describes
+static ring_buffer_status vector_length(const struct iovec* vector, int count, size_t* length) {
     ring_buffer_status result = RING_BUFFER_SUCCESS;
 
-    if (NULL != ring) {
-        ENTER_CRITICAL(ring);
-        
-        ring->write_callback.callback = callback;
-        ring->write_callback.threshold = threshold;
-        
-        EXIT_CRITICAL(ring, result);
+    *length = 0;
+
+    if ((0 <= count) && ((NULL != vector) || (0 == count))) {
+        for (int i = 0; (i < count) && (RING_BUFFER_SUCCESS == result); i++)
+            if ((NULL != vector[i].iov_base) || (0 == vector[i].iov_len))
+                *length += vector[i].iov_len;
+            else
+                result = RING_BUFFER_INVALID_ADDRESS;
     }
     else
         result = RING_BUFFER_INVALID_ADDRESS;
-    
+
     return result;
 }
 
 
-ring_buffer_status ring_buffer_write(ring_buffer* ring, const void* data, const size_t length) {
+static inline void fire_read_callback(struct _ring_buffer* ring) {
+    update_events(ring);
+
+    if (ring->read_callback.callback && (ring_buffer_readable(ring) >= ring->read_callback.threshold))
+        ring->read_callback.callback(ring);
+}
+
+
+static inline void fire_write_callback(struct _ring_buffer* ring) {
+    update_events(ring);
+
+    if (ring->write_callback.callback && (ring_buffer_writable(ring) >= ring->write_callback.threshold))
+        ring->write_callback.callback(ring);
+}
+
+
+static ring_buffer_status init_state(struct _ring_buffer_state* state, size_t capacity, int shared) {
     ring_buffer_status result = RING_BUFFER_SUCCESS;
+#ifdef RING_BUFFER_THREAD_SAFETY
+    pthread_mutexattr_t mutex_attributes;
+#endif
 
-    if ((NULL != ring) && (NULL != data)) {
-        ENTER_CRITICAL(ring);
+    if ((0 == pthread_mutexattr_init(&mutex_attributes)) && (0 == pthread_mutexattr_settype(&mutex_attributes, PTHREAD_MUTEX_RECURSIVE)) && (0 == pthread_mutexattr_setpshared(&mutex_attributes, shared ? PTHREAD_PROCESS_SHARED : PTHREAD_PROCESS_PRIVATE)) && (0 == pthread_mutexattr_setrobust(&mutex_attributes, PTHREAD_MUTEX_ROBUST)) && (0 == pthread_mutex_init(&state->lock, &mutex_attributes))) {
+        state->read = state->write = state->reserved = state->peeked = state->spliced = 0;
 
-        if (ring_buffer_writable(ring) >= length) {
-            size_t left = length;
+        // Attachers take a matching capacity as the sign that the rest of the block is ready
+        __atomic_store_n(&state->capacity, capacity, __ATOMIC_RELEASE);
+    }
+    else
+        result = RING_BUFFER_CONCURRENCY_ERROR;
 
-            do {
-                size_t target = ring->write % ring->capacity, size = min(left, ring->capacity - target);
+    return result;
+}
 
-                memcpy((char*)ring->buffer + target, (const char*)data + length - left, size);
-                left -= size;
-                ring->write += size;
-            } while (left > 0);
 
-            if (ring->read_callback.callback && (ring_buffer_readable(ring) >= ring->read_callback.threshold))
-                ring->read_callback.callback(ring);
-        }
-        else
-            result = RING_BUFFER_OVERFLOW;
-        
-        EXIT_CRITICAL(ring, result);
+// Callbacks and event descriptors only make sense inside one process, so they are
+// never part of the state block
+static void init_local(struct _ring_buffer* ring) {
+    ring->read_callback.callback = ring->write_callback.callback = NULL;
+    ring->read_event.fd = ring->write_event.fd = -1;
+}
+
+
+ring_buffer_status ring_buffer_attributes_init(ring_buffer_attributes* attributes) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if (NULL != attributes) {
+        attributes->flags = 0;
+        attributes->numa_node = RING_BUFFER_NUMA_ANY;
+        attributes->allocator = NULL;
     }
     else
         result = RING_BUFFER_INVALID_ADDRESS;
-    
+
     return result;
 }
 
 
-ring_buffer_status ring_buffer_read(ring_buffer* ring, void* data, const size_t length) {
-    ring_buffer_status result = RING_BUFFER_SUCCESS;
+ring_buffer_status ring_buffer_create(ring_buffer** ring, size_t capacity) {
+    ring_buffer_attributes attributes;
 
-    if ((NULL != ring) && (NULL != data)) {
-        ENTER_CRITICAL(ring);
+    ring_buffer_attributes_init(&attributes);
 
-        if (ring_buffer_readable(ring) >= length) {
-            size_t left = length;
+    return ring_buffer_create_with_attributes(ring, capacity, &attributes);
+}
 
-            do {
-                size_t target = ring->read % ring->capacity, size = min(left, ring->capacity - target);
 
-                memcpy((char*)data + length - left, (const char*)ring->buffer + target, size);
-                left -= size;
-                ring->read += size;
-            } while (left > 0);
+ring_buffer_status ring_buffer_create_with_attributes(ring_buffer** ring, size_t capacity, const ring_buffer_attributes* attributes) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if ((NULL != ring) && (NULL != attributes) && ((NULL == attributes->allocator) || ((NULL != attributes->allocator->allocate) && (NULL != attributes->allocator->deallocate)))) {
+        const ring_buffer_allocator* allocator = (NULL != attributes->allocator) ? attributes->allocator : &default_allocator;
+        struct _ring_buffer* _ring;
+        
+        if (NULL != (_ring = allocator->allocate(allocator->context, sizeof(struct _ring_buffer), RING_BUFFER_CACHE_LINE_SIZE))) {
+            _ring->capacity = capacity;
+            _ring->flags = attributes->flags;
+            _ring->state = &_ring->local;
+            _ring->allocator = *allocator;
 
-            if (ring->write_callback.callback && (ring_buffer_writable(ring) >= ring->write_callback.threshold))
-                ring->write_callback.callback(ring);
+            if (RING_BUFFER_SUCCESS == (result = allocate_buffer(_ring, attributes->numa_node))) {
+                if (RING_BUFFER_SUCCESS == (result = init_state(_ring->state, _ring->capacity, 0))) {
+                    init_local(_ring);
+                    *ring = _ring;
+                }
+                else {
+                    release_buffer(_ring);
+                    free_ring(_ring);
+                }
+            }
+            else
+                free_ring(_ring);
         }
         else
-            result = RING_BUFFER_UNDERFLOW;
-        
-        EXIT_CRITICAL(ring, result);
+            result = RING_BUFFER_OUT_OF_MEMORY;
     }
     else
         result = RING_BUFFER_INVALID_ADDRESS;
@@ -203,20 +581,599 @@ ring_buffer_status ring_buffer_read(ring_buffer* ring, void* data, const size_t
 }
 
 
-ring_buffer_status ring_buffer_get_available(ring_buffer* ring, size_t* read, size_t* write) {
+// Cursors and data live in the named POSIX shared memory object, which any process can
+// map with ring_buffer_attach_shared. The name stays until someone calls shm_unlink.
+// The capacity must be positive, since a zero one marks a block still being set up.
+ring_buffer_status ring_buffer_create_shared(ring_buffer** ring, const char* name, size_t capacity) {
     ring_buffer_status result = RING_BUFFER_SUCCESS;
 
-    if ((NULL != ring) && (NULL != read) && (NULL != write)) {
-        ENTER_CRITICAL(ring);
-        
-        *read = ring_buffer_readable(ring);
-        *write = ring_buffer_writable(ring);
-        
-        EXIT_CRITICAL(ring, result);
+    if ((NULL != ring) && (NULL != name) && (0 < capacity)) {
+        struct _ring_buffer* _ring;
+        int fd;
+
+        if (0 == posix_memalign((void**)&_ring, RING_BUFFER_CACHE_LINE_SIZE, sizeof(struct _ring_buffer))) {
+            _ring->allocator = default_allocator;
+
+            if (-1 != (fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR))) {
+                if ((0 == ftruncate(fd, shared_offset() + capacity)) && (RING_BUFFER_SUCCESS == (result = map_shared(_ring, fd, capacity)))) {
+                    if (RING_BUFFER_SUCCESS == (result = init_state(_ring->state, capacity, 1))) {
+                        init_local(_ring);
+                        *ring = _ring;
+                    }
+                    else
+                        release_buffer(_ring);
+                }
+                else
+                    result = RING_BUFFER_SYSTEM_ERROR;
+
+                close(fd);
+
+                if (RING_BUFFER_SUCCESS != result) {
+                    shm_unlink(name);
+                    free(_ring);
+                }
+            }
+            else {
+                free(_ring);
+                result = RING_BUFFER_SYSTEM_ERROR;
+            }
+        }
+        else
+            result = RING_BUFFER_OUT_OF_MEMORY;
     }
     else
         result = RING_BUFFER_INVALID_ADDRESS;
-    
+
+    return result;
+}
+
+
+// The capacity is recovered from the object size and checked against the state block,
+// which also catches an object whose creator has not initialized it yet
+ring_buffer_status ring_buffer_attach_shared(ring_buffer** ring, const char* name) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if ((NULL != ring) && (NULL != name)) {
+        struct _ring_buffer* _ring;
+        struct stat status;
+        int fd;
+
+        if (0 == posix_memalign((void**)&_ring, RING_BUFFER_CACHE_LINE_SIZE, sizeof(struct _ring_buffer))) {
+            _ring->allocator = default_allocator;
+
+            if (-1 != (fd = shm_open(name, O_RDWR, 0))) {
+                if ((0 == fstat(fd, &status)) && ((size_t)status.st_size > shared_offset()) && (RING_BUFFER_SUCCESS == (result = map_shared(_ring, fd, status.st_size - shared_offset())))) {
+                    if (__atomic_load_n(&_ring->state->capacity, __ATOMIC_ACQUIRE) == _ring->capacity) {
+                        init_local(_ring);
+                        *ring = _ring;
+                    }
+                    else {
+                        release_buffer(_ring);
+                        result = RING_BUFFER_SYSTEM_ERROR;
+                    }
+                }
+                else
+                    result = RING_BUFFER_SYSTEM_ERROR;
+
+                close(fd);
+            }
+            else
+                result = RING_BUFFER_SYSTEM_ERROR;
+
+            if (RING_BUFFER_SUCCESS != result)
+                free(_ring);
+        }
+        else
+            result = RING_BUFFER_OUT_OF_MEMORY;
+    }
+    else
+        result = RING_BUFFER_INVALID_ADDRESS;
+
+    return result;
+}
+
+
+ring_buffer_status ring_buffer_set_read_callback(ring_buffer* ring, ring_buffer_callback callback, size_t threshold)
+{
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if (NULL != ring) {
+        ENTER_CRITICAL(ring);
+        
+        ring->read_callback.callback = callback;
+        ring->read_callback.threshold = threshold;
+        
+        EXIT_CRITICAL(ring, result);
+    }
+    else
+        result = RING_BUFFER_INVALID_ADDRESS;
+    
+    return result;
+}
+
+
+ring_buffer_status ring_buffer_set_write_callback(ring_buffer* ring, ring_buffer_callback callback, size_t threshold) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if (NULL != ring) {
+        ENTER_CRITICAL(ring);
+        
+        ring->write_callback.callback = callback;
+        ring->write_callback.threshold = threshold;
+        
+        EXIT_CRITICAL(ring, result);
+    }
+    else
+        result = RING_BUFFER_INVALID_ADDRESS;
+    
+    return result;
+}
+
+
+ring_buffer_status ring_buffer_set_read_eventfd(ring_buffer* ring, size_t threshold, int* fd) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if ((NULL != ring) && (NULL != fd)) {
+        ENTER_CRITICAL(ring);
+
+        if (RING_BUFFER_SUCCESS == (result = set_event(&ring->read_event, threshold, fd)))
+            update_events(ring);
+
+        EXIT_CRITICAL(ring, result);
+    }
+    else
+        result = RING_BUFFER_INVALID_ADDRESS;
+
+    return result;
+}
+
+
+ring_buffer_status ring_buffer_set_write_eventfd(ring_buffer* ring, size_t threshold, int* fd) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if ((NULL != ring) && (NULL != fd)) {
+        ENTER_CRITICAL(ring);
+
+        if (RING_BUFFER_SUCCESS == (result = set_event(&ring->write_event, threshold, fd)))
+            update_events(ring);
+
+        EXIT_CRITICAL(ring, result);
+    }
+    else
+        result = RING_BUFFER_INVALID_ADDRESS;
+
+    return result;
+}
+
+
+ring_buffer_status ring_buffer_write(ring_buffer* ring, const void* data, const size_t length) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if ((NULL != ring) && (NULL != data)) {
+        ENTER_CRITICAL(ring);
+
+        if (ring_buffer_writable(ring) >= length) {
+            copy_to(ring, ring->state->write, data, length);
+            ring->state->write += length;
+            ring->state->reserved = 0;
+            fire_read_callback(ring);
+        }
+        else
+            result = RING_BUFFER_OVERFLOW;
+        
+        EXIT_CRITICAL(ring, result);
+    }
+    else
+        result = RING_BUFFER_INVALID_ADDRESS;
+    
+    return result;
+}
+
+
+ring_buffer_status ring_buffer_read(ring_buffer* ring, void* data, const size_t length) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if ((NULL != ring) && (NULL != data)) {
+        ENTER_CRITICAL(ring);
+
+        if (ring_buffer_readable(ring) >= length) {
+            copy_from(ring, ring->state->read, data, length);
+            ring->state->read += length;
+            ring->state->peeked = 0;
+            fire_write_callback(ring);
+        }
+        else
+            result = RING_BUFFER_UNDERFLOW;
+        
+        EXIT_CRITICAL(ring, result);
+    }
+    else
+        result = RING_BUFFER_INVALID_ADDRESS;
+    
+    return result;
+}
+
+
+// All segments move under one critical section and callbacks fire once for the whole vector
+ring_buffer_status ring_buffer_writev(ring_buffer* ring, const struct iovec* vector, int count) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+    size_t length;
+
+    if ((NULL != ring) && (RING_BUFFER_SUCCESS == (result = vector_length(vector, count, &length)))) {
+        ENTER_CRITICAL(ring);
+
+        if (ring_buffer_writable(ring) >= length) {
+            size_t position = ring->state->write;
+
+            for (int i = 0; i < count; position += vector[i].iov_len, i++)
+                copy_to(ring, position, vector[i].iov_base, vector[i].iov_len);
+
+            ring->state->write = position;
+            ring->state->reserved = 0;
+            fire_read_callback(ring);
+        }
+        else
+            result = RING_BUFFER_OVERFLOW;
+
+        EXIT_CRITICAL(ring, result);
+    }
+    else if (NULL == ring)
+        result = RING_BUFFER_INVALID_ADDRESS;
+
+    return result;
+}
+
+
+ring_buffer_status ring_buffer_readv(ring_buffer* ring, const struct iovec* vector, int count) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+    size_t length;
+
+    if ((NULL != ring) && (RING_BUFFER_SUCCESS == (result = vector_length(vector, count, &length)))) {
+        ENTER_CRITICAL(ring);
+
+        if (ring_buffer_readable(ring) >= length) {
+            size_t position = ring->state->read;
+
+            for (int i = 0; i < count; position += vector[i].iov_len, i++)
+                copy_from(ring, position, vector[i].iov_base, vector[i].iov_len);
+
+            ring->state->read = position;
+            ring->state->peeked = 0;
+            fire_write_callback(ring);
+        }
+        else
+            result = RING_BUFFER_UNDERFLOW;
+
+        EXIT_CRITICAL(ring, result);
+    }
+    else if (NULL == ring)
+        result = RING_BUFFER_INVALID_ADDRESS;
+
+    return result;
+}
+
+
+// Transfers as much as fits (possibly nothing) and reports the count, like POSIX write
+ring_buffer_status ring_buffer_write_some(ring_buffer* ring, const void* data, const size_t length, size_t* written) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if ((NULL != ring) && (NULL != data) && (NULL != written)) {
+        ENTER_CRITICAL(ring);
+
+        *written = min(length, ring_buffer_writable(ring));
+
+        if (*written > 0) {
+            copy_to(ring, ring->state->write, data, *written);
+            ring->state->write += *written;
+            ring->state->reserved = 0;
+            fire_read_callback(ring);
+        }
+
+        EXIT_CRITICAL(ring, result);
+    }
+    else
+        result = RING_BUFFER_INVALID_ADDRESS;
+
+    return result;
+}
+
+
+ring_buffer_status ring_buffer_read_some(ring_buffer* ring, void* data, const size_t length, size_t* read) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if ((NULL != ring) && (NULL != data) && (NULL != read)) {
+        ENTER_CRITICAL(ring);
+
+        *read = min(length, ring_buffer_readable(ring));
+
+        if (*read > 0) {
+            copy_from(ring, ring->state->read, data, *read);
+            ring->state->read += *read;
+            ring->state->peeked = 0;
+            fire_write_callback(ring);
+        }
+
+        EXIT_CRITICAL(ring, result);
+    }
+    else
+        result = RING_BUFFER_INVALID_ADDRESS;
+
+    return result;
+}
+
+
+// Reads straight from the descriptor into the free space, with no intermediate copy.
+// The lock is held across the syscall, so fd should be non-blocking. A descriptor with
+// nothing ready fails with EAGAIN in errno, so zero bytes with space available means end
+// of file. Nothing has been transferred when a call fails.
+ring_buffer_status ring_buffer_fill_from_fd(ring_buffer* ring, int fd, size_t max, size_t* transferred) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if ((NULL != ring) && (NULL != transferred)) {
+        *transferred = 0;
+        ENTER_CRITICAL(ring);
+
+        struct iovec vector[2];
+        size_t length = min(max, ring_buffer_writable(ring));
+        ssize_t count = 0;
+
+        if ((0 == length) || (0 <= (count = readv(fd, vector, get_vector(ring, ring->state->write, length, vector))))) {
+            *transferred = count;
+
+            if (count > 0) {
+                ring->state->write += count;
+                ring->state->reserved = 0;
+                fire_read_callback(ring);
+            }
+        }
+        else
+            result = RING_BUFFER_SYSTEM_ERROR;
+
+        EXIT_CRITICAL(ring, result);
+    }
+    else
+        result = RING_BUFFER_INVALID_ADDRESS;
+
+    return result;
+}
+
+
+ring_buffer_status ring_buffer_drain_to_fd(ring_buffer* ring, int fd, size_t max, size_t* transferred) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if ((NULL != ring) && (NULL != transferred)) {
+        *transferred = 0;
+        ENTER_CRITICAL(ring);
+
+        struct iovec vector[2];
+        size_t length = min(max, ring_buffer_readable(ring));
+        ssize_t count = 0;
+
+        if ((0 == length) || (0 <= (count = writev(fd, vector, get_vector(ring, ring->state->read, length, vector))))) {
+            *transferred = count;
+
+            if (count > 0) {
+                ring->state->read += count;
+                ring->state->peeked = 0;
+                fire_write_callback(ring);
+            }
+        }
+        else
+            result = RING_BUFFER_SYSTEM_ERROR;
+
+        EXIT_CRITICAL(ring, result);
+    }
+    else
+        result = RING_BUFFER_INVALID_ADDRESS;
+
+    return result;
+}
+
+
+// Bytes handed to a pipe with vmsplice have left the ring but their pages are still
+// referenced by the pipe, so that space is only reclaimed once the pipe has drained
+// them. This assumes the ring is the only writer of that pipe and that its reader copies
+// the bytes out.
+static ring_buffer_status reclaim_spliced(struct _ring_buffer* ring, int fd) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+    int pending;
+
+    if (0 == ioctl(fd, FIONREAD, &pending)) {
+        if ((size_t)pending < ring->state->spliced) {
+            ring->state->spliced = pending;
+            fire_write_callback(ring);
+        }
+    }
+    else
+        result = RING_BUFFER_SYSTEM_ERROR;
+
+    return result;
+}
+
+
+// Maps the readable bytes into a pipe without copying them. The read cursor advances by
+// what the kernel took. The pipe must be consumed with read() or another call that
+// copies: splicing it onward (into a socket, say) keeps the ring's pages referenced after
+// the pipe has drained, which nothing here can see, so writers would overwrite bytes
+// still in flight.
+ring_buffer_status ring_buffer_splice_to_pipe(ring_buffer* ring, int fd, size_t max, size_t* transferred) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if ((NULL != ring) && (NULL != transferred)) {
+        *transferred = 0;
+        ENTER_CRITICAL(ring);
+
+        struct iovec vector[2];
+        size_t length = min(max, ring_buffer_readable(ring));
+        ssize_t count = 0;
+
+        if ((RING_BUFFER_SUCCESS == (result = reclaim_spliced(ring, fd))) && ((0 == length) || (0 <= (count = vmsplice(fd, vector, get_vector(ring, ring->state->read, length, vector), SPLICE_F_NONBLOCK))))) {
+            *transferred = count;
+
+            if (count > 0) {
+                ring->state->read += count;
+                ring->state->peeked = 0;
+                ring->state->spliced += count;
+                update_events(ring);
+            }
+        }
+        else
+            result = RING_BUFFER_SYSTEM_ERROR;
+
+        EXIT_CRITICAL(ring, result);
+    }
+    else
+        result = RING_BUFFER_INVALID_ADDRESS;
+
+    return result;
+}
+
+
+ring_buffer_status ring_buffer_reclaim_spliced(ring_buffer* ring, int fd, size_t* pending) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if ((NULL != ring) && (NULL != pending)) {
+        ENTER_CRITICAL(ring);
+
+        result = reclaim_spliced(ring, fd);
+        *pending = ring->state->spliced;
+
+        EXIT_CRITICAL(ring, result);
+    }
+    else
+        result = RING_BUFFER_INVALID_ADDRESS;
+
+    return result;
+}
+
+
+// Any other write before the commit cancels the reservation, whose spans it may overlap
+ring_buffer_status ring_buffer_reserve(ring_buffer* ring, size_t length, ring_buffer_span spans[2]) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if ((NULL != ring) && (NULL != spans)) {
+        ENTER_CRITICAL(ring);
+
+        if (ring_buffer_writable(ring) >= length) {
+            get_spans(ring, ring->state->write, length, spans);
+            ring->state->reserved = length;
+        }
+        else
+            result = RING_BUFFER_OVERFLOW;
+
+        EXIT_CRITICAL(ring, result);
+    }
+    else
+        result = RING_BUFFER_INVALID_ADDRESS;
+
+    return result;
+}
+
+
+ring_buffer_status ring_buffer_commit(ring_buffer* ring, size_t length) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if (NULL != ring) {
+        ENTER_CRITICAL(ring);
+
+        // Committing less than the reservation publishes a prefix and drops the rest
+        if (ring->state->reserved >= length) {
+            ring->state->write += length;
+            ring->state->reserved = 0;
+            fire_read_callback(ring);
+        }
+        else
+            result = RING_BUFFER_OVERFLOW;
+
+        EXIT_CRITICAL(ring, result);
+    }
+    else
+        result = RING_BUFFER_INVALID_ADDRESS;
+
+    return result;
+}
+
+
+// Any other read before the consume cancels the peek, whose spans it may have released
+ring_buffer_status ring_buffer_peek(ring_buffer* ring, ring_buffer_span spans[2]) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if ((NULL != ring) && (NULL != spans)) {
+        ENTER_CRITICAL(ring);
+
+        ring->state->peeked = ring_buffer_readable(ring);
+        get_spans(ring, ring->state->read, ring->state->peeked, spans);
+
+        EXIT_CRITICAL(ring, result);
+    }
+    else
+        result = RING_BUFFER_INVALID_ADDRESS;
+
+    return result;
+}
+
+
+ring_buffer_status ring_buffer_consume(ring_buffer* ring, size_t length) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if (NULL != ring) {
+        ENTER_CRITICAL(ring);
+
+        // Consuming less than was peeked releases a prefix and leaves the rest readable
+        if (ring->state->peeked >= length) {
+            ring->state->read += length;
+            ring->state->peeked = 0;
+            fire_write_callback(ring);
+        }
+        else
+            result = RING_BUFFER_UNDERFLOW;
+
+        EXIT_CRITICAL(ring, result);
+    }
+    else
+        result = RING_BUFFER_INVALID_ADDRESS;
+
+    return result;
+}
+
+
+ring_buffer_status ring_buffer_skip(ring_buffer* ring, size_t length) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if (NULL != ring) {
+        ENTER_CRITICAL(ring);
+
+        if (ring_buffer_readable(ring) >= length) {
+            ring->state->read += length;
+            ring->state->peeked = 0;
+            fire_write_callback(ring);
+        }
+        else
+            result = RING_BUFFER_UNDERFLOW;
+
+        EXIT_CRITICAL(ring, result);
+    }
+    else
+        result = RING_BUFFER_INVALID_ADDRESS;
+
+    return result;
+}
+
+
+ring_buffer_status ring_buffer_get_available(ring_buffer* ring, size_t* read, size_t* write) {
+    ring_buffer_status result = RING_BUFFER_SUCCESS;
+
+    if ((NULL != ring) && (NULL != read) && (NULL != write)) {
+        ENTER_CRITICAL(ring);
+        
+        *read = ring_buffer_readable(ring);
+        *write = ring_buffer_writable(ring);
+        
+        EXIT_CRITICAL(ring, result);
+    }
+    else
+        result = RING_BUFFER_INVALID_ADDRESS;
+    
     return result;
 }
 
@@ -225,11 +1182,21 @@ ring_buffer_status ring_buffer_destroy(ring_buffer* ring) {
     ring_buffer_status result = RING_BUFFER_SUCCESS;
     
     if (NULL != ring) {
-        if (0 == pthread_mutex_lock(&ring->lock)) {
-            free(ring->buffer);
-            free(ring);
-            pthread_mutex_unlock(&ring->lock);
-            pthread_mutex_destroy(&ring->lock); 
+        if (0 == lock_state(ring->state)) {
+            if (-1 != ring->read_event.fd)
+                close(ring->read_event.fd);
+
+            if (-1 != ring->write_event.fd)
+                close(ring->write_event.fd);
+
+            pthread_mutex_unlock(&ring->state->lock);
+
+            // Other processes may still be using a shared lock, only unmap it
+            if (!ring_buffer_shared(ring))
+                pthread_mutex_destroy(&ring->state->lock);
+
+            release_buffer(ring);
+            free_ring(ring);
         }
         else
             result = RING_BUFFER_CONCURRENCY_ERROR;
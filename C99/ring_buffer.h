@@ -22,6 +22,7 @@
 #define __RING_BUFFER_H__
 
 #include <stddef.h>
+#include <sys/uio.h>
 
 
 typedef struct _ring_buffer ring_buffer;
@@ -32,17 +33,67 @@ typedef enum {
     RING_BUFFER_OUT_OF_MEMORY,
     RING_BUFFER_OVERFLOW,
     RING_BUFFER_UNDERFLOW,
-    RING_BUFFER_CONCURRENCY_ERROR
+    RING_BUFFER_CONCURRENCY_ERROR,
+    RING_BUFFER_SYSTEM_ERROR
 } ring_buffer_status;
 
+typedef enum {
+    RING_BUFFER_MIRRORED = 1, /* Map the storage twice back to back (capacity is rounded up to whole pages) */
+    RING_BUFFER_POWER_OF_TWO = 2, /* Round capacity up to a power of two so positions are masked instead of divided */
+    RING_BUFFER_HUGE_PAGES = 4, /* Back the storage with huge pages if the pool has them, otherwise advise transparent huge pages */
+    RING_BUFFER_LOCKED = 8, /* Lock the storage in memory (subject to RLIMIT_MEMLOCK) */
+    RING_BUFFER_PREFAULT = 16 /* Fault every page in at creation rather than on first use */
+} ring_buffer_flags;
+
+#define RING_BUFFER_NUMA_ANY (-1) /* Leave page placement to the kernel */
+#define RING_BUFFER_NUMA_LOCAL (-2) /* Bind to the node of the calling CPU, so create the ring from the consumer */
+
+/* Source of the ring object and of storage that is not mapped; both are requested with
+   cache line alignment and handed back with the same size */
+typedef struct {
+    void* (*allocate)(void* context, size_t size, size_t alignment);
+    void (*deallocate)(void* context, void* data, size_t size);
+    void* context;
+} ring_buffer_allocator;
+
+typedef struct {
+    unsigned int flags;
+    int numa_node; /* Node to bind the storage to, or one of the RING_BUFFER_NUMA_ values */
+    const ring_buffer_allocator* allocator; /* NULL for the C library heap; copied, so it need not outlive the call */
+} ring_buffer_attributes;
+
+typedef struct {
+    void* data;
+    size_t length;
+} ring_buffer_span;
+
 typedef void (*ring_buffer_callback)(ring_buffer* ring);
 
 
+ring_buffer_status ring_buffer_attributes_init(ring_buffer_attributes* attributes);
 ring_buffer_status ring_buffer_create(ring_buffer** ring, size_t capacity);
+ring_buffer_status ring_buffer_create_with_attributes(ring_buffer** ring, size_t capacity, const ring_buffer_attributes* attributes);
+ring_buffer_status ring_buffer_create_shared(ring_buffer** ring, const char* name, size_t capacity);
+ring_buffer_status ring_buffer_attach_shared(ring_buffer** ring, const char* name);
 ring_buffer_status ring_buffer_set_read_callback(ring_buffer* ring, ring_buffer_callback callback, size_t threshold);
 ring_buffer_status ring_buffer_set_write_callback(ring_buffer* ring, ring_buffer_callback callback, size_t threshold);
+ring_buffer_status ring_buffer_set_read_eventfd(ring_buffer* ring, size_t threshold, int* fd);
+ring_buffer_status ring_buffer_set_write_eventfd(ring_buffer* ring, size_t threshold, int* fd);
 ring_buffer_status ring_buffer_write(ring_buffer* ring, const void* data, size_t length);
 ring_buffer_status ring_buffer_read(ring_buffer* ring, void* data, size_t length);
+ring_buffer_status ring_buffer_writev(ring_buffer* ring, const struct iovec* vector, int count);
+ring_buffer_status ring_buffer_readv(ring_buffer* ring, const struct iovec* vector, int count);
+ring_buffer_status ring_buffer_write_some(ring_buffer* ring, const void* data, size_t length, size_t* written);
+ring_buffer_status ring_buffer_read_some(ring_buffer* ring, void* data, size_t length, size_t* read);
+ring_buffer_status ring_buffer_fill_from_fd(ring_buffer* ring, int fd, size_t max, size_t* transferred);
+ring_buffer_status ring_buffer_drain_to_fd(ring_buffer* ring, int fd, size_t max, size_t* transferred);
+ring_buffer_status ring_buffer_splice_to_pipe(ring_buffer* ring, int fd, size_t max, size_t* transferred);
+ring_buffer_status ring_buffer_reclaim_spliced(ring_buffer* ring, int fd, size_t* pending);
+ring_buffer_status ring_buffer_reserve(ring_buffer* ring, size_t length, ring_buffer_span spans[2]);
+ring_buffer_status ring_buffer_commit(ring_buffer* ring, size_t length);
+ring_buffer_status ring_buffer_peek(ring_buffer* ring, ring_buffer_span spans[2]);
+ring_buffer_status ring_buffer_consume(ring_buffer* ring, size_t length);
+ring_buffer_status ring_buffer_skip(ring_buffer* ring, size_t length);
 ring_buffer_status ring_buffer_get_available(ring_buffer* ring, size_t* read, size_t* write);
 ring_buffer_status ring_buffer_destroy(ring_buffer* ring);
 
@@ -18,8 +18,20 @@
 */
 
 
+#define _POSIX_C_SOURCE 200809L
+
 #include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
 #include "ring_buffer.h"
 
 
@@ -101,6 +113,43 @@ static void async() {
 }
 
 
+static int signalled(int fd) {
+    uint64_t value;
+
+    return sizeof(value) == read(fd, &value, sizeof(value));
+}
+
+
+static void events() {
+    ring_buffer* buffer;
+    unsigned char temp_buffer[16] = { 0 };
+    int read_fd, write_fd, fd;
+
+    assert(RING_BUFFER_SUCCESS == ring_buffer_create(&buffer, 16));
+    assert(RING_BUFFER_SUCCESS == ring_buffer_set_read_eventfd(buffer, 8, &read_fd));
+    assert(RING_BUFFER_SUCCESS == ring_buffer_set_write_eventfd(buffer, 12, &write_fd));
+    assert(!signalled(read_fd) && signalled(write_fd));
+
+    // Crossing the threshold signals once, staying above it does not signal again
+    assert(RING_BUFFER_SUCCESS == ring_buffer_write(buffer, temp_buffer, 4));
+    assert(!signalled(read_fd));
+    assert(RING_BUFFER_SUCCESS == ring_buffer_write(buffer, temp_buffer, 4));
+    assert(signalled(read_fd));
+    assert(RING_BUFFER_SUCCESS == ring_buffer_write(buffer, temp_buffer, 4));
+    assert(!signalled(read_fd) && !signalled(write_fd));
+
+    // Dropping below the threshold rearms the event
+    assert(RING_BUFFER_SUCCESS == ring_buffer_read(buffer, temp_buffer, 8));
+    assert(!signalled(read_fd) && signalled(write_fd));
+    assert(RING_BUFFER_SUCCESS == ring_buffer_write(buffer, temp_buffer, 4));
+    assert(signalled(read_fd));
+
+    assert(RING_BUFFER_SUCCESS == ring_buffer_set_read_eventfd(buffer, 4, &fd) && (fd == read_fd));
+    assert(RING_BUFFER_INVALID_ADDRESS == ring_buffer_set_read_eventfd(buffer, 4, NULL));
+    assert(RING_BUFFER_SUCCESS == ring_buffer_destroy(buffer));
+}
+
+
 static unsigned char write_counter = 0;
 static unsigned char read_counter = 0;
 
@@ -204,6 +253,277 @@ static void interleaved(const size_t byte_count, const size_t ring_buffer_size,
 }
 
 
+static void partial(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    ring_buffer* buffer;
+    void* temp_buffer = malloc(max_block_size);
+    size_t count = 0, transferred;
+
+    assert(RING_BUFFER_SUCCESS == ring_buffer_create(&buffer, ring_buffer_size));
+    assert((RING_BUFFER_SUCCESS == ring_buffer_read_some(buffer, temp_buffer, max_block_size, &transferred)) && (transferred == 0));
+    sync();
+
+    while (count < byte_count) {
+        size_t length = rand() % max_block_size;
+
+        produce(temp_buffer, length);
+        assert((RING_BUFFER_SUCCESS == ring_buffer_write_some(buffer, temp_buffer, length, &transferred)) && (transferred <= length));
+        revert(length - transferred);
+
+        length = rand() % max_block_size;
+        assert((RING_BUFFER_SUCCESS == ring_buffer_read_some(buffer, temp_buffer, length, &transferred)) && (transferred <= length));
+        verify(temp_buffer, transferred);
+        count += transferred;
+    }
+
+    assert(RING_BUFFER_SUCCESS == ring_buffer_destroy(buffer));
+    free(temp_buffer);
+}
+
+
+// Blocks are split into three segments at random points on both sides
+static void split(struct iovec vector[3], void* data, size_t length) {
+    size_t first = rand() % (length + 1), second = first + rand() % (length - first + 1);
+
+    vector[0].iov_base = data;
+    vector[0].iov_len = first;
+    vector[1].iov_base = (char*)data + first;
+    vector[1].iov_len = second - first;
+    vector[2].iov_base = (char*)data + second;
+    vector[2].iov_len = length - second;
+}
+
+
+static void vectored(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    ring_buffer* buffer;
+    struct iovec vector[3];
+    void* temp_buffer = malloc(max_block_size);
+    size_t count = 0;
+
+    assert(RING_BUFFER_SUCCESS == ring_buffer_create(&buffer, ring_buffer_size));
+    assert(RING_BUFFER_INVALID_ADDRESS == ring_buffer_writev(buffer, NULL, 1));
+    sync();
+
+    while (count < byte_count) {
+        size_t length = rand() % max_block_size;
+        ring_buffer_status status;
+
+        produce(temp_buffer, length);
+        split(vector, temp_buffer, length);
+        assert((RING_BUFFER_SUCCESS == (status = ring_buffer_writev(buffer, vector, 3))) || (RING_BUFFER_OVERFLOW == status));
+
+        if (RING_BUFFER_OVERFLOW == status)
+            revert(length);
+
+        length = rand() % max_block_size;
+        split(vector, temp_buffer, length);
+
+        if (RING_BUFFER_SUCCESS == ring_buffer_readv(buffer, vector, 3)) {
+            verify(temp_buffer, length);
+            count += length;
+        }
+    }
+
+    assert(RING_BUFFER_SUCCESS == ring_buffer_destroy(buffer));
+    free(temp_buffer);
+}
+
+
+// Bytes go producer -> pipe -> ring -> pipe -> consumer, entering and leaving the ring
+// only through the descriptor operations
+static void descriptors(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    ring_buffer* buffer;
+    void* temp_buffer = malloc(ring_buffer_size + max_block_size);
+    size_t count = 0, transferred, readable, writable;
+    int input[2], output[2];
+
+    assert((0 == pipe(input)) && (0 == pipe(output)));
+    assert(-1 != fcntl(input[0], F_SETFL, O_NONBLOCK));
+    assert(RING_BUFFER_SUCCESS == ring_buffer_create(&buffer, ring_buffer_size));
+    transferred = 1;
+    assert((RING_BUFFER_SYSTEM_ERROR == ring_buffer_fill_from_fd(buffer, input[0], max_block_size, &transferred)) && (EAGAIN == errno) && (0 == transferred));
+    sync();
+
+    while (count < byte_count) {
+        size_t length = rand() % max_block_size;
+
+        // Filling takes up to twice the average block so the input pipe keeps draining
+        produce(temp_buffer, length);
+        assert(length == (size_t)write(input[1], temp_buffer, length));
+        assert((RING_BUFFER_SUCCESS == ring_buffer_fill_from_fd(buffer, input[0], rand() % (2 * max_block_size), &transferred)) || (EAGAIN == errno));
+
+        assert(RING_BUFFER_SUCCESS == ring_buffer_drain_to_fd(buffer, output[1], rand() % ring_buffer_size, &transferred));
+        assert(transferred == (size_t)read(output[0], temp_buffer, transferred));
+        verify(temp_buffer, transferred);
+        count += transferred;
+    }
+
+    // Once the writer is gone the drained pipe reads as end of file rather than EAGAIN
+    close(input[1]);
+
+    do
+        assert((RING_BUFFER_SUCCESS == ring_buffer_get_available(buffer, &readable, &writable)) && (RING_BUFFER_SUCCESS == ring_buffer_skip(buffer, readable)) && (RING_BUFFER_SUCCESS == ring_buffer_fill_from_fd(buffer, input[0], ring_buffer_size, &transferred)));
+    while (0 < transferred);
+
+    assert(RING_BUFFER_SUCCESS == ring_buffer_destroy(buffer));
+    close(input[0]);
+    close(output[0]);
+    close(output[1]);
+    free(temp_buffer);
+}
+
+
+// Bytes spliced into a pipe keep their space until the pipe has been read
+static void spliced(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    ring_buffer* buffer;
+    void* temp_buffer = malloc(ring_buffer_size);
+    size_t count = 0, transferred, pending, readable, writable;
+    int output[2];
+
+    assert(0 == pipe(output));
+    assert(RING_BUFFER_SUCCESS == ring_buffer_create(&buffer, ring_buffer_size));
+    assert((RING_BUFFER_SYSTEM_ERROR == ring_buffer_reclaim_spliced(buffer, -1, &pending)) && (EBADF == errno));
+    sync();
+
+    while (count < byte_count) {
+        size_t length = rand() % max_block_size;
+
+        produce(temp_buffer, length);
+
+        if (RING_BUFFER_OVERFLOW == ring_buffer_write(buffer, temp_buffer, length))
+            revert(length);
+
+        assert(RING_BUFFER_SUCCESS == ring_buffer_splice_to_pipe(buffer, output[1], rand() % ring_buffer_size, &transferred));
+        assert((RING_BUFFER_SUCCESS == ring_buffer_get_available(buffer, &readable, &writable)) && (readable + writable + transferred == ring_buffer_size));
+        assert(transferred == (size_t)read(output[0], temp_buffer, transferred));
+        verify(temp_buffer, transferred);
+        count += transferred;
+
+        assert((RING_BUFFER_SUCCESS == ring_buffer_reclaim_spliced(buffer, output[1], &pending)) && (0 == pending));
+        assert((RING_BUFFER_SUCCESS == ring_buffer_get_available(buffer, &readable, &writable)) && (readable + writable == ring_buffer_size));
+    }
+
+    // A full pipe takes nothing, and the call says so rather than leaving transferred unset
+    assert(-1 != fcntl(output[1], F_SETFL, O_NONBLOCK));
+
+    while (0 < write(output[1], temp_buffer, ring_buffer_size))
+        ;
+
+    if (0 == readable)
+        assert(RING_BUFFER_SUCCESS == ring_buffer_write(buffer, temp_buffer, 1));
+
+    transferred = 1;
+    assert((RING_BUFFER_SYSTEM_ERROR == ring_buffer_splice_to_pipe(buffer, output[1], ring_buffer_size, &transferred)) && (EAGAIN == errno) && (0 == transferred));
+
+    assert(RING_BUFFER_SUCCESS == ring_buffer_destroy(buffer));
+    close(output[0]);
+    close(output[1]);
+    free(temp_buffer);
+}
+
+
+static void reserve_commit(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    ring_buffer* buffer;
+    ring_buffer_span spans[2];
+    void* temp_buffer = malloc(max_block_size);
+    size_t count = 0, read, write;
+
+    assert(RING_BUFFER_SUCCESS == ring_buffer_create(&buffer, ring_buffer_size));
+    assert(RING_BUFFER_OVERFLOW == ring_buffer_reserve(buffer, ring_buffer_size + 1, spans));
+    assert(RING_BUFFER_OVERFLOW == ring_buffer_commit(buffer, 1));
+    sync();
+
+    while (count < byte_count) {
+        size_t length = rand() % max_block_size;
+
+        if (RING_BUFFER_SUCCESS == ring_buffer_reserve(buffer, length, spans)) {
+            assert(spans[0].length + spans[1].length == length);
+            produce(spans[0].data, spans[0].length);
+            produce(spans[1].data, spans[1].length);
+            assert(RING_BUFFER_SUCCESS == ring_buffer_commit(buffer, length));
+        }
+
+        length = rand() % max_block_size;
+
+        if (RING_BUFFER_UNDERFLOW != ring_buffer_read(buffer, temp_buffer, length)) {
+            verify(temp_buffer, length);
+            count += length;
+        }
+    }
+
+    // A partial commit only publishes the leading bytes of the reservation
+    assert((RING_BUFFER_SUCCESS == ring_buffer_get_available(buffer, &read, &write)) && (write > 0));
+    assert(RING_BUFFER_SUCCESS == ring_buffer_reserve(buffer, write, spans));
+    assert(RING_BUFFER_SUCCESS == ring_buffer_commit(buffer, 1));
+    assert((RING_BUFFER_SUCCESS == ring_buffer_get_available(buffer, &count, &write)) && (count == read + 1));
+    assert(RING_BUFFER_OVERFLOW == ring_buffer_commit(buffer, 1));
+
+    // A write in between cancels the reservation instead of publishing bytes nobody wrote
+    assert((RING_BUFFER_SUCCESS == ring_buffer_get_available(buffer, &read, &write)) && (RING_BUFFER_SUCCESS == ring_buffer_skip(buffer, read)));
+    assert(RING_BUFFER_SUCCESS == ring_buffer_reserve(buffer, ring_buffer_size, spans));
+    assert(RING_BUFFER_SUCCESS == ring_buffer_write(buffer, temp_buffer, 1));
+    assert(RING_BUFFER_OVERFLOW == ring_buffer_commit(buffer, ring_buffer_size));
+    assert((RING_BUFFER_SUCCESS == ring_buffer_get_available(buffer, &read, &write)) && (read == 1));
+
+    assert(RING_BUFFER_SUCCESS == ring_buffer_destroy(buffer));
+    free(temp_buffer);
+}
+
+
+static void peek_consume(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    ring_buffer* buffer;
+    ring_buffer_span spans[2];
+    void* temp_buffer = malloc(max_block_size);
+    size_t count = 0, read, write;
+
+    assert(RING_BUFFER_SUCCESS == ring_buffer_create(&buffer, ring_buffer_size));
+    assert((RING_BUFFER_SUCCESS == ring_buffer_peek(buffer, spans)) && (spans[0].length == 0) && (spans[1].length == 0));
+    assert(RING_BUFFER_UNDERFLOW == ring_buffer_consume(buffer, 1));
+    assert(RING_BUFFER_UNDERFLOW == ring_buffer_skip(buffer, 1));
+    sync();
+
+    while (count < byte_count) {
+        size_t length = rand() % max_block_size;
+
+        produce(temp_buffer, length);
+
+        if (RING_BUFFER_OVERFLOW == ring_buffer_write(buffer, temp_buffer, length))
+            revert(length);
+
+        assert(RING_BUFFER_SUCCESS == ring_buffer_peek(buffer, spans));
+        length = rand() % max_block_size;
+
+        if (length > spans[0].length + spans[1].length)
+            length = spans[0].length + spans[1].length;
+
+        // Alternate between verifying in place and discarding without a copy
+        if (rand() % 2) {
+            size_t head = (length < spans[0].length) ? length : spans[0].length;
+
+            verify(spans[0].data, head);
+            verify(spans[1].data, length - head);
+            assert(RING_BUFFER_SUCCESS == ring_buffer_consume(buffer, length));
+        }
+        else {
+            read_counter += length;
+            assert(RING_BUFFER_SUCCESS == ring_buffer_skip(buffer, length));
+        }
+
+        count += length;
+    }
+
+    // A read in between cancels the peek instead of releasing bytes twice
+    assert((RING_BUFFER_SUCCESS == ring_buffer_get_available(buffer, &read, &write)) && (RING_BUFFER_SUCCESS == ring_buffer_skip(buffer, read)));
+    assert(RING_BUFFER_SUCCESS == ring_buffer_write(buffer, temp_buffer, 2));
+    assert(RING_BUFFER_SUCCESS == ring_buffer_peek(buffer, spans));
+    assert(RING_BUFFER_SUCCESS == ring_buffer_skip(buffer, 1));
+    assert(RING_BUFFER_UNDERFLOW == ring_buffer_consume(buffer, 2));
+    assert((RING_BUFFER_SUCCESS == ring_buffer_get_available(buffer, &read, &write)) && (read == 1));
+
+    assert(RING_BUFFER_SUCCESS == ring_buffer_destroy(buffer));
+    free(temp_buffer);
+}
+
+
 static void huge() {
     const size_t buffer_size = 1024*1024;
     ring_buffer* buffer;
@@ -222,11 +542,260 @@ static void huge() {
 }
 
 
+static void attributed(const unsigned int flags, const size_t byte_count, const size_t max_block_size) {
+    ring_buffer* buffer;
+    ring_buffer_attributes attributes;
+    void* temp_buffer = malloc(max_block_size);
+    size_t count = 0, read, write;
+
+    assert(RING_BUFFER_SUCCESS == ring_buffer_attributes_init(&attributes));
+    attributes.flags = flags;
+    assert(RING_BUFFER_SUCCESS == ring_buffer_create_with_attributes(&buffer, 1000, &attributes));
+    assert((RING_BUFFER_SUCCESS == ring_buffer_get_available(buffer, &read, &write)) && (read == 0) && (write >= 1000));
+    assert(!(flags & RING_BUFFER_POWER_OF_TWO) || (0 == (write & (write - 1))));
+    sync();
+
+    while (count < byte_count) {
+        size_t length = rand() % max_block_size;
+
+        produce(temp_buffer, length);
+
+        if (RING_BUFFER_OVERFLOW == ring_buffer_write(buffer, temp_buffer, length))
+            revert(length);
+
+        length = rand() % max_block_size;
+
+        if (RING_BUFFER_UNDERFLOW != ring_buffer_read(buffer, temp_buffer, length)) {
+            verify(temp_buffer, length);
+            count += length;
+        }
+    }
+
+    assert(RING_BUFFER_SUCCESS == ring_buffer_destroy(buffer));
+    free(temp_buffer);
+
+    // No power of two at or above this capacity fits in a size_t
+    if (flags & RING_BUFFER_POWER_OF_TWO)
+        assert(RING_BUFFER_OUT_OF_MEMORY == ring_buffer_create_with_attributes(&buffer, SIZE_MAX, &attributes));
+}
+
+
+struct arena {
+    char* base;
+    size_t used, live;
+};
+
+
+static void* arena_allocate(void* context, size_t size, size_t alignment) {
+    struct arena* arena = context;
+    void* result = arena->base + (arena->used + alignment - 1) / alignment * alignment;
+
+    arena->used = (char*)result - arena->base + size;
+    arena->live++;
+
+    return result;
+}
+
+
+static void arena_deallocate(void* context, void* data, size_t size) {
+    ((struct arena*)context)->live--;
+}
+
+
+// Rings and their storage are carved out of one block and handed back to it
+static void allocated(const size_t ring_count, const size_t ring_buffer_size) {
+    struct arena arena = { malloc(ring_count * (ring_buffer_size + 1024)), 0, 0 };
+    ring_buffer_allocator allocator = { arena_allocate, arena_deallocate, &arena };
+    ring_buffer_attributes attributes;
+    ring_buffer** buffers = malloc(ring_count * sizeof(ring_buffer*));
+    void* temp_buffer = malloc(ring_buffer_size);
+
+    assert(RING_BUFFER_SUCCESS == ring_buffer_attributes_init(&attributes));
+    attributes.allocator = &allocator;
+
+    for (size_t i = 0; i < ring_count; i++) {
+        assert(RING_BUFFER_SUCCESS == ring_buffer_create_with_attributes(&buffers[i], ring_buffer_size, &attributes));
+        assert(((char*)buffers[i] >= arena.base) && ((char*)buffers[i] < arena.base + arena.used));
+    }
+
+    assert((arena.live == 2 * ring_count) && (arena.used <= ring_count * (ring_buffer_size + 1024)));
+    sync();
+
+    for (size_t i = 0; i < ring_count; i++) {
+        produce(temp_buffer, ring_buffer_size);
+        assert(RING_BUFFER_SUCCESS == ring_buffer_write(buffers[i], temp_buffer, ring_buffer_size));
+    }
+
+    for (size_t i = 0; i < ring_count; i++) {
+        assert(RING_BUFFER_SUCCESS == ring_buffer_read(buffers[i], temp_buffer, ring_buffer_size));
+        verify(temp_buffer, ring_buffer_size);
+        assert(RING_BUFFER_SUCCESS == ring_buffer_destroy(buffers[i]));
+    }
+
+    assert(0 == arena.live);
+
+    allocator.deallocate = NULL;
+    assert(RING_BUFFER_INVALID_ADDRESS == ring_buffer_create_with_attributes(&buffers[0], ring_buffer_size, &attributes));
+
+    free(temp_buffer);
+    free(buffers);
+    free(arena.base);
+}
+
+
+// NUMA binding goes through mbind, which rejects nodes that do not exist. Even an empty
+// ring gets mapped storage, which must be unmapped rather than freed.
+static void placed() {
+    ring_buffer* buffer;
+    ring_buffer_attributes attributes;
+
+    assert(RING_BUFFER_SUCCESS == ring_buffer_attributes_init(&attributes));
+    attributes.flags = RING_BUFFER_PREFAULT;
+    assert(RING_BUFFER_SUCCESS == ring_buffer_create_with_attributes(&buffer, 0, &attributes));
+    assert(RING_BUFFER_SUCCESS == ring_buffer_destroy(buffer));
+
+    attributes.numa_node = 0;
+    assert(RING_BUFFER_SUCCESS == ring_buffer_create_with_attributes(&buffer, 1000, &attributes));
+    assert(RING_BUFFER_SUCCESS == ring_buffer_destroy(buffer));
+
+    attributes.numa_node = RING_BUFFER_NUMA_LOCAL;
+    assert(RING_BUFFER_SUCCESS == ring_buffer_create_with_attributes(&buffer, 1000, &attributes));
+    assert(RING_BUFFER_SUCCESS == ring_buffer_destroy(buffer));
+
+    attributes.numa_node = 1000000;
+    assert((RING_BUFFER_SYSTEM_ERROR == ring_buffer_create_with_attributes(&buffer, 1000, &attributes)) && (EINVAL == errno));
+}
+
+
+// A child process attaches by name and reads back everything the parent writes
+static void shared(const size_t byte_count, const size_t ring_buffer_size, const size_t max_block_size) {
+    ring_buffer* buffer;
+    char name[64];
+    pid_t child;
+    int status, fd, truncated;
+
+    snprintf(name, sizeof(name), "/ring_buffer_test_%d", (int)getpid());
+    assert(RING_BUFFER_SUCCESS == ring_buffer_create_shared(&buffer, name, ring_buffer_size));
+    assert(RING_BUFFER_SYSTEM_ERROR == ring_buffer_create_shared(&buffer, name, ring_buffer_size));
+    assert(RING_BUFFER_INVALID_ADDRESS == ring_buffer_create_shared(&buffer, "/ring_buffer_test_empty", 0));
+    sync();
+
+    if (0 == (child = fork())) {
+        ring_buffer* other;
+        void* temp_buffer = malloc(max_block_size);
+        size_t count = 0;
+
+        assert(RING_BUFFER_SUCCESS == ring_buffer_attach_shared(&other, name));
+
+        while (count < byte_count) {
+            size_t length = rand() % max_block_size;
+
+            if (count + length > byte_count)
+                length = byte_count - count;
+
+            if (RING_BUFFER_SUCCESS == ring_buffer_read(other, temp_buffer, length)) {
+                verify(temp_buffer, length);
+                count += length;
+            }
+            else
+                sched_yield();
+        }
+
+        assert(RING_BUFFER_SUCCESS == ring_buffer_destroy(other));
+        free(temp_buffer);
+        exit(0);
+    }
+    else {
+        void* temp_buffer = malloc(max_block_size);
+        size_t count = 0;
+
+        while (count < byte_count) {
+            size_t length = rand() % max_block_size;
+
+            if (count + length > byte_count)
+                length = byte_count - count;
+
+            produce(temp_buffer, length);
+
+            if (RING_BUFFER_SUCCESS == ring_buffer_write(buffer, temp_buffer, length))
+                count += length;
+            else {
+                revert(length);
+                sched_yield();
+            }
+        }
+
+        assert((child == waitpid(child, &status, 0)) && WIFEXITED(status) && (0 == WEXITSTATUS(status)));
+        assert(RING_BUFFER_SUCCESS == ring_buffer_destroy(buffer));
+        assert(0 == shm_unlink(name));
+        assert(RING_BUFFER_SYSTEM_ERROR == ring_buffer_attach_shared(&buffer, name));
+        free(temp_buffer);
+    }
+
+    // An object whose state block was never published cannot be attached
+    snprintf(name, sizeof(name), "/ring_buffer_test_%d_raw", (int)getpid());
+    fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, S_IRUSR | S_IWUSR);
+    assert(-1 != fd);
+    truncated = ftruncate(fd, 1024*1024);
+    assert(0 == truncated);
+    close(fd);
+    assert(RING_BUFFER_SYSTEM_ERROR == ring_buffer_attach_shared(&buffer, name));
+    shm_unlink(name);
+}
+
+
+#ifdef RING_BUFFER_THREAD_SAFETY
+static void die(ring_buffer* ring) {
+    _exit(0);
+}
+
+
+// A child fills a reservation and dies before committing it, inside the critical
+// section of an unrelated read (from a callback): the parent must get the lock back
+// and find the reservation rolled back, with none of the child's bytes readable
+static void recovery() {
+    ring_buffer* buffer;
+    ring_buffer_span spans[2];
+    unsigned int foo = 0xDEADFACE;
+    unsigned char bar = 0x42;
+    char name[64];
+    size_t read, write;
+    pid_t child;
+    int status;
+
+    snprintf(name, sizeof(name), "/ring_buffer_test_%d", (int)getpid());
+    assert(RING_BUFFER_SUCCESS == ring_buffer_create_shared(&buffer, name, 16));
+    assert(RING_BUFFER_SUCCESS == ring_buffer_write(buffer, &bar, sizeof(bar)));
+
+    if (0 == (child = fork())) {
+        ring_buffer* other;
+
+        assert(RING_BUFFER_SUCCESS == ring_buffer_attach_shared(&other, name));
+        assert((RING_BUFFER_SUCCESS == ring_buffer_reserve(other, sizeof(foo), spans)) && (spans[0].length == sizeof(foo)));
+        memcpy(spans[0].data, &foo, sizeof(foo));
+
+        assert(RING_BUFFER_SUCCESS == ring_buffer_set_write_callback(other, die, 0));
+        ring_buffer_read(other, &bar, sizeof(bar));
+        exit(1);
+    }
+
+    assert((child == waitpid(child, &status, 0)) && WIFEXITED(status) && (0 == WEXITSTATUS(status)));
+    assert((RING_BUFFER_SUCCESS == ring_buffer_get_available(buffer, &read, &write)) && (read == 0));
+    assert(RING_BUFFER_OVERFLOW == ring_buffer_commit(buffer, sizeof(foo)));
+    assert((RING_BUFFER_SUCCESS == ring_buffer_get_available(buffer, &read, &write)) && (read == 0));
+    assert(RING_BUFFER_SUCCESS == ring_buffer_destroy(buffer));
+    assert(0 == shm_unlink(name));
+}
+#endif
+
+
 int main() {
     simple();
 
     async();
 
+    events();
+
     sequential(1024*1024*16, 1024, 16);
     sequential(1024*1024*16, 1024, 512);
     sequential(1024*1024*16, 1024, 1024);
@@ -235,7 +804,41 @@ int main() {
     interleaved(1024*1024*16, 1024, 512);
     interleaved(1024*1024*16, 1024, 1024);
     
+    partial(1024*1024*16, 1000, 16);
+    partial(1024*1024*16, 1000, 2048);
+
+    vectored(1024*1024*16, 1000, 16);
+    vectored(1024*1024*16, 1000, 512);
+
+    descriptors(1024*1024, 1000, 16);
+    descriptors(1024*1024*16, 1000, 512);
+
+    spliced(1024*1024, 1000, 16);
+    spliced(1024*1024*16, 1000, 512);
+
+    reserve_commit(1024*1024*16, 1000, 16);
+    reserve_commit(1024*1024*16, 1000, 512);
+
+    peek_consume(1024*1024*16, 1000, 16);
+    peek_consume(1024*1024*16, 1000, 512);
+
     huge();
 
+    attributed(RING_BUFFER_MIRRORED, 1024*1024*16, 1024);
+    attributed(RING_BUFFER_MIRRORED, 1024*1024*16, 8192);
+    attributed(RING_BUFFER_POWER_OF_TWO, 1024*1024*16, 16);
+    attributed(RING_BUFFER_POWER_OF_TWO, 1024*1024*16, 1024);
+    attributed(RING_BUFFER_HUGE_PAGES | RING_BUFFER_PREFAULT, 1024*1024*16, 1024);
+    attributed(RING_BUFFER_MIRRORED | RING_BUFFER_HUGE_PAGES | RING_BUFFER_LOCKED, 1024*1024*16, 1024);
+    attributed(RING_BUFFER_POWER_OF_TWO | RING_BUFFER_LOCKED | RING_BUFFER_PREFAULT, 1024*1024*16, 16);
+
+    placed();
+    allocated(1000, 1000);
+
+    shared(1024*1024*16, 1000, 512);
+#ifdef RING_BUFFER_THREAD_SAFETY
+    recovery();
+#endif
+
     return 0;   
 }